@@ -0,0 +1,139 @@
+/*
+ * File:   AtomicBench.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<pthread.h>
+#include "List.h"
+#include "AtomicList.h"
+
+#define USAGE "Usage: AtomicBench [element count]\n"
+
+// Most producer threads tried.
+#define MAX_PRODUCERS 32
+
+// private ProducerArgs type
+typedef struct ProducerArgs {
+	AtomicList Q;       // the AtomicList, or NULL for the locked List
+	int first;          // first value appended
+	int count;          // number of values appended
+} ProducerArgs;
+
+// The mutex-wrapped List, as clients had to share a List before.
+List shared;
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// elapsed()
+// Returns the seconds from start to now.
+double elapsed(struct timespec start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// produce()
+// Appends the values of its ProducerArgs one at a time.
+void* produce(void* arg) {
+	ProducerArgs* a = arg;
+	for (int i = a->first; i < a->first + a->count; i++) {
+		if (a->Q != NULL) {
+			appendAtomicList(a->Q, i);
+		}
+		else {
+			pthread_mutex_lock(&lock);
+			append(shared, i);
+			pthread_mutex_unlock(&lock);
+		}
+	}
+	return NULL;
+}
+
+// consume()
+// Deletes n values from the front of Q, or of the locked List if Q is NULL,
+// as they arrive. Returns their sum.
+long long consume(AtomicList Q, int n) {
+	long long sum = 0;
+	int taken = 0;
+	while (taken < n) {
+		if (Q != NULL) {
+			if (!isEmptyAtomicList(Q)) {
+				sum += frontAtomicList(Q);
+				deleteFrontAtomicList(Q);
+				taken++;
+			}
+		}
+		else {
+			pthread_mutex_lock(&lock);
+			if (length(shared) > 0) {
+				sum += front(shared);
+				deleteFront(shared);
+				taken++;
+			}
+			pthread_mutex_unlock(&lock);
+		}
+	}
+	return sum;
+}
+
+// bench()
+// Runs p producers appending n values in all to Q, or to the locked List
+// if Q is NULL, while this thread deletes them, and reports the throughput.
+// Exits if the values taken do not add up.
+void bench(AtomicList Q, int p, int n) {
+	pthread_t thread[MAX_PRODUCERS];
+	ProducerArgs args[MAX_PRODUCERS];
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int t = 0; t < p; t++) {
+		args[t].Q = Q;
+		args[t].first = (int)((long long)n * t / p);
+		args[t].count = (int)((long long)n * (t + 1) / p) - args[t].first;
+		if (pthread_create(&thread[t], NULL, produce, &args[t]) != 0) {
+			fprintf(stderr, "Error: cannot create producer thread\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	long long sum = consume(Q, n);
+	for (int t = 0; t < p; t++) {
+		pthread_join(thread[t], NULL);
+	}
+	double secs = elapsed(start);
+	if (sum != (long long)n * (n - 1) / 2) {
+		fprintf(stderr, "Error: %s consumer took the wrong values\n", Q != NULL ? "atomic" : "mutex");
+		exit(EXIT_FAILURE);
+	}
+	printf("%-7s %2d producers %8.2f M elements/s\n", Q != NULL ? "atomic" : "mutex", p,
+		n / secs / 1e6);
+}
+
+int main(int argc, char* argv[]) {
+	int n = 1000000;
+	char* end;
+	if (argc > 2) {
+		fprintf(stderr, USAGE);
+		exit(EXIT_FAILURE);
+	}
+	if (argc > 1) {
+		n = (int)strtol(argv[1], &end, 10);
+		if (end == argv[1] || *end != '\0' || n < 1) {
+			fprintf(stderr, "Error: invalid element count '%s'\n", argv[1]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (int p = 1; p <= MAX_PRODUCERS; p *= 2) {
+		shared = newList();
+		bench(NULL, p, n);
+		freeList(&shared);
+
+		AtomicList Q = newAtomicList();
+		bench(Q, p, n);
+		freeAtomicList(&Q);
+	}
+	return 0;
+}
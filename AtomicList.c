@@ -0,0 +1,229 @@
+/*
+ * File:   AtomicList.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<assert.h>
+#include<stdint.h>
+#include<stdatomic.h>
+#include<sched.h>
+#include "AtomicList.h"
+
+// Producers appending at once beyond HAZARD_SLOTS wait for a free slot.
+#define HAZARD_SLOTS 64
+
+// Deleted nodes are held back until RETIRE_LIMIT of them have piled up,
+// then every one not named by a hazard pointer is freed.
+#define RETIRE_LIMIT (4 * HAZARD_SLOTS)
+
+// Size of a cache line, to keep producer and consumer fields apart.
+#define CACHE_LINE 64
+
+// FAIL_IF()
+// Reports msg and exits if the precondition failure cond holds. With
+// LIST_UNCHECKED it is only an assert(), which NDEBUG compiles out.
+#ifdef LIST_UNCHECKED
+#define FAIL_IF(cond, msg) assert(!(cond))
+#else
+#define FAIL_IF(cond, msg) do { if (cond) { fputs(msg, stderr); exit(EXIT_FAILURE); } } while (0)
+#endif
+
+// private AtomicNodeObj type
+typedef struct AtomicNodeObj {
+    int data;
+    _Atomic(struct AtomicNodeObj*) next;
+} AtomicNodeObj;
+
+// private AtomicNode type
+typedef AtomicNodeObj* AtomicNode;
+
+// private HazardObj type
+// A hazard pointer: while node is set, the consumer will not free it.
+typedef struct HazardObj {
+    atomic_int busy;            // claimed by a producer
+    _Atomic(AtomicNode) node;
+    char pad[CACHE_LINE - sizeof(atomic_int) - sizeof(_Atomic(AtomicNode))];
+} HazardObj;
+
+// private AtomicListObj type
+// front is a dummy node whose successor holds the front element; back is
+// the last node or, briefly, the one before it.
+typedef struct AtomicListObj {
+    _Atomic(AtomicNode) back;
+    char pad[CACHE_LINE - sizeof(_Atomic(AtomicNode))];
+    AtomicNode front;
+    AtomicNode retired[RETIRE_LIMIT];   // deleted, not yet freed
+    int retired_count;
+    HazardObj hazard[HAZARD_SLOTS];
+} AtomicListObj;
+
+// Hazard pointer functions ---------------------------------------------------
+
+// claimHazard()
+// Returns a hazard slot of Q reserved for the calling thread, searching
+// from a slot picked by the thread's stack address.
+static HazardObj* claimHazard(AtomicList Q) {
+    int here;
+    int i = (int)(((uintptr_t)&here >> 12) % HAZARD_SLOTS);
+    for (;;) {
+        for (int k = 0; k < HAZARD_SLOTS; k++, i = (i + 1) % HAZARD_SLOTS) {
+            int idle = 0;
+            if (atomic_load_explicit(&Q->hazard[i].busy, memory_order_relaxed) == 0 &&
+                atomic_compare_exchange_strong(&Q->hazard[i].busy, &idle, 1)) {
+                return &Q->hazard[i];
+            }
+        }
+        sched_yield();
+    }
+}
+
+// releaseHazard()
+// Clears hazard slot H and gives it back.
+static void releaseHazard(HazardObj* H) {
+    atomic_store(&H->node, NULL);
+    atomic_store_explicit(&H->busy, 0, memory_order_release);
+}
+
+// retireNode()
+// Frees N once no hazard pointer of Q names it. Every RETIRE_LIMIT nodes,
+// the hazard pointers are scanned and all unnamed retired nodes freed.
+static void retireNode(AtomicList Q, AtomicNode N) {
+    Q->retired[Q->retired_count++] = N;
+    if (Q->retired_count < RETIRE_LIMIT) {
+        return;
+    }
+    AtomicNode named[HAZARD_SLOTS];
+    int n = 0;
+    for (int i = 0; i < HAZARD_SLOTS; i++) {
+        AtomicNode M = atomic_load(&Q->hazard[i].node);
+        if (M != NULL) {
+            named[n++] = M;
+        }
+    }
+    int kept = 0;
+    for (int r = 0; r < Q->retired_count; r++) {
+        int safe = 1;
+        for (int i = 0; i < n && safe; i++) {
+            safe = (named[i] != Q->retired[r]);
+        }
+        if (safe) {
+            free(Q->retired[r]);
+        }
+        else {
+            Q->retired[kept++] = Q->retired[r];
+        }
+    }
+    Q->retired_count = kept;
+}
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newAtomicList()
+// Returns reference to new empty AtomicList object.
+AtomicList newAtomicList(void) {
+    AtomicList Q = malloc(sizeof(AtomicListObj));
+    AtomicNode D = malloc(sizeof(AtomicNodeObj));
+    D->data = 0;
+    atomic_init(&D->next, NULL);
+    atomic_init(&Q->back, D);
+    Q->front = D;
+    Q->retired_count = 0;
+    for (int i = 0; i < HAZARD_SLOTS; i++) {
+        atomic_init(&Q->hazard[i].busy, 0);
+        atomic_init(&Q->hazard[i].node, NULL);
+    }
+    return Q;
+}
+
+// freeAtomicList()
+// Frees all heap memory associated with AtomicList *pQ, and sets *pQ to
+// NULL. No other thread may be using it.
+// Pre: AtomicList != NULL
+void freeAtomicList(AtomicList* pQ) {
+    FAIL_IF(pQ == NULL || *pQ == NULL, "AtomicList Error: calling freeAtomicList() on NULL AtomicList reference\n");
+    AtomicNode N = (*pQ)->front;
+    while (N != NULL) {
+        AtomicNode M = atomic_load(&N->next);
+        free(N);
+        N = M;
+    }
+    for (int r = 0; r < (*pQ)->retired_count; r++) {
+        free((*pQ)->retired[r]);
+    }
+    free(*pQ);
+    *pQ = NULL;
+}
+
+// Access functions -----------------------------------------------------------
+
+// isEmptyAtomicList()
+// Returns true (1) iff Q has no elements. Consumer only.
+// Pre: AtomicList != NULL
+int isEmptyAtomicList(AtomicList Q) {
+    FAIL_IF(Q == NULL, "AtomicList Error: calling isEmptyAtomicList() on NULL AtomicList reference\n");
+    return atomic_load(&Q->front->next) == NULL;
+}
+
+// frontAtomicList()
+// Returns the front element of Q. Consumer only.
+// Pre: AtomicList != NULL, !isEmptyAtomicList(Q)
+int frontAtomicList(AtomicList Q) {
+    FAIL_IF(Q == NULL, "AtomicList Error: calling frontAtomicList() on NULL AtomicList reference\n");
+    AtomicNode N = atomic_load(&Q->front->next);
+    FAIL_IF(N == NULL, "AtomicList Error: calling frontAtomicList() on an empty AtomicList\n");
+    return N->data;
+}
+
+// Manipulation procedures ----------------------------------------------------
+
+// appendAtomicList()
+// Inserts data after the back element of Q. Safe to call from any number
+// of threads at once, and alongside the consumer.
+// Pre: AtomicList != NULL
+void appendAtomicList(AtomicList Q, int data) {
+    FAIL_IF(Q == NULL, "AtomicList Error: calling appendAtomicList() on NULL AtomicList reference\n");
+    AtomicNode N = malloc(sizeof(AtomicNodeObj));
+    N->data = data;
+    atomic_init(&N->next, NULL);
+    HazardObj* H = claimHazard(Q);
+    for (;;) {
+        AtomicNode last = atomic_load(&Q->back);
+        // publish the hazard, then make sure last was not retired before it
+        // became visible: the consumer only retires nodes back has left
+        atomic_store(&H->node, last);
+        if (atomic_load(&Q->back) != last) {
+            continue;
+        }
+        AtomicNode next = atomic_load(&last->next);
+        if (next != NULL) {
+            // another producer linked a node but has not swung back yet
+            atomic_compare_exchange_strong(&Q->back, &last, next);
+            continue;
+        }
+        if (atomic_compare_exchange_strong(&last->next, &next, N)) {
+            atomic_compare_exchange_strong(&Q->back, &last, N);
+            break;
+        }
+    }
+    releaseHazard(H);
+}
+
+// deleteFrontAtomicList()
+// Deletes the front element of Q. Consumer only. Its node becomes the new
+// dummy front node, and the old one is retired.
+// Pre: AtomicList != NULL, !isEmptyAtomicList(Q)
+void deleteFrontAtomicList(AtomicList Q) {
+    FAIL_IF(Q == NULL, "AtomicList Error: calling deleteFrontAtomicList() on NULL AtomicList reference\n");
+    AtomicNode D = Q->front;
+    AtomicNode N = atomic_load(&D->next);
+    FAIL_IF(N == NULL, "AtomicList Error: calling deleteFrontAtomicList() on an empty AtomicList\n");
+    // back must leave D before D is retired, or a producer could pick it
+    // up after the hazard scan
+    AtomicNode last = D;
+    atomic_compare_exchange_strong(&Q->back, &last, N);
+    Q->front = N;
+    retireNode(Q, D);
+}
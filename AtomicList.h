@@ -0,0 +1,57 @@
+/*
+ * File:   AtomicList.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ * A List of ints that any number of threads may append to at once while
+ * one consumer thread reads and deletes from the front, without locks.
+ */
+
+#ifndef ATOMIC_LIST_H_INCLUDE_
+#define ATOMIC_LIST_H_INCLUDE_
+
+// Exported type --------------------------------------------------------------
+
+// An AtomicList is a Michael-Scott queue: a producer links its node after
+// the back node with a compare-and-swap and then swings back forward, and
+// the consumer unlinks from the front. Nodes the consumer deletes are freed
+// only once no producer holds a hazard pointer to them.
+typedef struct AtomicListObj* AtomicList;
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newAtomicList()
+// Returns reference to new empty AtomicList object.
+AtomicList newAtomicList(void);
+
+// freeAtomicList()
+// Frees all heap memory associated with AtomicList *pQ, and sets *pQ to
+// NULL. No other thread may be using it.
+// Pre: AtomicList != NULL
+void freeAtomicList(AtomicList* pQ);
+
+// Access functions -----------------------------------------------------------
+
+// isEmptyAtomicList()
+// Returns true (1) iff Q has no elements. Consumer only.
+// Pre: AtomicList != NULL
+int isEmptyAtomicList(AtomicList Q);
+
+// frontAtomicList()
+// Returns the front element of Q. Consumer only.
+// Pre: AtomicList != NULL, !isEmptyAtomicList(Q)
+int frontAtomicList(AtomicList Q);
+
+// Manipulation procedures ----------------------------------------------------
+
+// appendAtomicList()
+// Inserts data after the back element of Q. Safe to call from any number
+// of threads at once, and alongside the consumer.
+// Pre: AtomicList != NULL
+void appendAtomicList(AtomicList Q, int data);
+
+// deleteFrontAtomicList()
+// Deletes the front element of Q. Consumer only.
+// Pre: AtomicList != NULL, !isEmptyAtomicList(Q)
+void deleteFrontAtomicList(AtomicList Q);
+
+#endif
@@ -0,0 +1,415 @@
+/*
+ * File:   ExternalSort.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<errno.h>
+#include<unistd.h>
+#include "List.h"
+#include "Lines.h"
+#include "ParallelSort.h"
+#include "ExternalSort.h"
+
+// Bytes a buffered line costs besides its text: its view and its List node.
+#define LINE_OVERHEAD (sizeof(LineView) + 32)
+
+// Most spilled runs merged at once; more than this take extra passes.
+#define MERGE_FAN 64
+
+// Largest and least buffer given to every temporary file and to every run
+// being read. The buffers of a merge share the memory budget, so a small
+// budget gets smaller buffers and, below MERGE_FAN of the least, fewer runs
+// merged at once.
+#define SPILL_BUFFER 65536
+#define SPILL_BUFFER_MIN 4096
+
+// A spilled run is a sequence of records, each a uint64_t byte count
+// followed by that many bytes of line, newline included if it had one.
+// Counting bytes rather than relying on the newline keeps a final line
+// without one, or a line holding NUL bytes, intact.
+
+// private SpillObj type: runs laid end to end in one temporary file
+typedef struct SpillObj {
+    FILE* file;
+    off_t* bound;       // run i spans bytes bound[i] up to bound[i + 1]
+    int count;
+    int capacity;
+    size_t buffer;      // bytes of the buffer of the file and of every run read
+} SpillObj;
+
+// private RunObj type
+typedef struct RunObj {
+    int fd;
+    off_t next;         // offset of the first byte not yet buffered
+    off_t end;          // offset just past the run
+    char* buffer;
+    size_t size;        // bytes of buffer
+    size_t start;       // first unread byte in buffer
+    size_t filled;
+    char* line;
+    uint64_t length;
+    size_t capacity;
+    long order;         // position among the runs being merged
+} RunObj;
+
+// private Run type
+typedef RunObj* Run;
+
+// private BufferObj type: the lines of the run being collected
+typedef struct BufferObj {
+    char* text;
+    size_t used;
+    size_t capacity;
+    LineView* view;
+    size_t count;
+    size_t view_capacity;
+} BufferObj;
+
+// openSpill()
+// Returns a new anonymous temporary file with a stdio buffer of the given
+// size, or NULL on failure.
+static FILE* openSpill(size_t buffer) {
+    const char* dir = getenv("TMPDIR");
+    if (dir == NULL || *dir == '\0') {
+        dir = "/tmp";
+    }
+    size_t n = strlen(dir) + sizeof("/LexXXXXXX");
+    char* path = malloc(n);
+    snprintf(path, n, "%s/LexXXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        free(path);
+        return NULL;
+    }
+    unlink(path);
+    free(path);
+    FILE* f = fdopen(fd, "w+");
+    if (f == NULL) {
+        close(fd);
+        return NULL;
+    }
+    setvbuf(f, NULL, _IOFBF, buffer);
+    return f;
+}
+
+// putLine()
+// Writes n bytes of line s to f, as a record if record is set and as plain
+// text otherwise, adding what a record costs to stats->spilled.
+static void putLine(FILE* f, const char* s, uint64_t n, int record, ExternalStats* stats) {
+    if (record) {
+        fwrite(&n, sizeof(n), 1, f);
+        stats->spilled += sizeof(n) + n;
+    }
+    fwrite(s, 1, n, f);
+}
+
+// readRun()
+// Copies the next n bytes of R to dst, refilling its buffer from the file
+// as needed. Returns 0 on success and -1 on a read error or if the run
+// ends first.
+static int readRun(Run R, void* dst, uint64_t n) {
+    char* d = dst;
+    while (n > 0) {
+        if (R->start == R->filled) {
+            off_t left = R->end - R->next;
+            size_t want = ((size_t)left < R->size ? (size_t)left : R->size);
+            ssize_t got = (want > 0 ? pread(R->fd, R->buffer, want, R->next) : 0);
+            if (got <= 0) {
+                if (got == 0) errno = EIO;
+                return -1;
+            }
+            R->next += got;
+            R->start = 0;
+            R->filled = got;
+        }
+        size_t m = (n < R->filled - R->start ? (size_t)n : R->filled - R->start);
+        memcpy(d, R->buffer + R->start, m);
+        R->start += m;
+        d += m;
+        n -= m;
+    }
+    return 0;
+}
+
+// nextLine()
+// Reads the next record of R into its line buffer. Returns 1 if a record
+// was read, 0 at the end of the run and -1 on a read error.
+static int nextLine(Run R) {
+    if (R->start == R->filled && R->next == R->end) {
+        return 0;
+    }
+    if (readRun(R, &R->length, sizeof(R->length)) != 0) {
+        return -1;
+    }
+    if (R->length > R->capacity) {
+        R->capacity = R->length;
+        R->line = realloc(R->line, R->capacity);
+    }
+    return (readRun(R, R->line, R->length) == 0 ? 1 : -1);
+}
+
+// runBefore()
+// Returns true (1) iff the current line of R goes before that of S.
+static int runBefore(Run R, Run S) {
+    uint64_t n = (R->length < S->length ? R->length : S->length);
+    int c = memcmp(R->line, S->line, n);
+    if (c == 0) {
+        c = (R->length > S->length) - (R->length < S->length);
+    }
+    return c < 0 || (c == 0 && R->order < S->order);
+}
+
+// siftDown()
+// Restores the heap order of the n runs in heap below position i.
+static void siftDown(Run* heap, int n, int i) {
+    for (;;) {
+        int m = i;
+        int l = 2 * i + 1;
+        if (l < n && runBefore(heap[l], heap[m])) m = l;
+        if (l + 1 < n && runBefore(heap[l + 1], heap[m])) m = l + 1;
+        if (m == i) return;
+        Run t = heap[i];
+        heap[i] = heap[m];
+        heap[m] = t;
+        i = m;
+    }
+}
+
+// mergeSpills()
+// Merges the k runs of S from run first on, in order, into out, as records
+// if record is set and as plain text otherwise. Every run is read through a
+// buffer of its own, of the size S gives, so only the one file of S is
+// open. Returns 0 on
+// success and -1 on a read error.
+static int mergeSpills(const SpillObj* S, int first, int k, FILE* out, int record,
+                       ExternalStats* stats) {
+    RunObj* runs = calloc(k, sizeof(RunObj));
+    Run* heap = malloc(k * sizeof(Run));
+    char* buffers = malloc((size_t)k * S->buffer);
+    int n = 0;
+    int status = 0;
+    for (int i = 0; i < k; i++) {
+        runs[i].fd = fileno(S->file);
+        runs[i].next = S->bound[first + i];
+        runs[i].end = S->bound[first + i + 1];
+        runs[i].buffer = buffers + (size_t)i * S->buffer;
+        runs[i].size = S->buffer;
+        runs[i].order = i;
+        int r = nextLine(&runs[i]);
+        if (r < 0) status = -1;
+        if (r > 0) heap[n++] = &runs[i];
+    }
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        siftDown(heap, n, i);
+    }
+    while (n > 0 && status == 0) {
+        Run R = heap[0];
+        putLine(out, R->line, R->length, record, stats);
+        int r = nextLine(R);
+        if (r < 0) status = -1;
+        if (r <= 0) heap[0] = heap[--n];
+        siftDown(heap, n, 0);
+    }
+    for (int i = 0; i < k; i++) {
+        free(runs[i].line);
+    }
+    free(runs);
+    free(heap);
+    free(buffers);
+    return status;
+}
+
+// emitBuffer()
+// Sorts the lines collected in B, with sorter on threads workers, and writes
+// them to out, as records if record is set and as plain text otherwise.
+// Empties B.
+static void emitBuffer(BufferObj* B, FILE* out, int record, int threads, LineSorter sorter,
+                       ExternalStats* stats) {
+    LineTable table = { B->text, B->view };
+    if (threads > 1 || sorter != NULL) {
+        int* order = malloc((B->count > 0 ? B->count : 1) * sizeof(int));
+        for (size_t i = 0; i < B->count; i++) {
+            order[i] = (int)i;
+        }
+        if (threads > 1) {
+            parallelSort(&table, order, (int)B->count, threads, sorter);
+        }
+        else {
+            sorter(&table, order, (int)B->count);
+        }
+        for (size_t i = 0; i < B->count; i++) {
+            LineView v = B->view[order[i]];
+            putLine(out, B->text + v.offset, v.length, record, stats);
+        }
+        free(order);
+        B->used = 0;
+        B->count = 0;
+        return;
+    }
+    List A = newList();
+    for (size_t i = 0; i < B->count; i++) {
+        append(A, (int)i);
+    }
+    sortList(A, compareLines, &table);
+    for (moveFront(A); index(A) >= 0; moveNext(A)) {
+        LineView v = B->view[get(A)];
+        putLine(out, B->text + v.offset, v.length, record, stats);
+    }
+    freeList(&A);
+    B->used = 0;
+    B->count = 0;
+}
+
+// spillRun()
+// Sorts the lines collected in B, as emitBuffer() does, and appends them to
+// the file of S as its next run, opening the file with the first. Returns 0
+// on success and -1 if the file cannot be opened or written.
+static int spillRun(SpillObj* S, BufferObj* B, int threads, LineSorter sorter,
+                    ExternalStats* stats) {
+    if (S->file == NULL && (S->file = openSpill(S->buffer)) == NULL) {
+        return -1;
+    }
+    if (S->count + 2 > S->capacity) {
+        S->capacity = (S->capacity == 0 ? 16 : 2 * S->capacity);
+        S->bound = realloc(S->bound, S->capacity * sizeof(off_t));
+    }
+    if (S->count == 0) {
+        rewind(S->file);
+        S->bound[0] = 0;
+    }
+    emitBuffer(B, S->file, 1, threads, sorter, stats);
+    if (fflush(S->file) != 0 || (S->bound[S->count + 1] = ftello(S->file)) < 0) {
+        return -1;
+    }
+    S->count++;
+    return 0;
+}
+
+// externalSort()
+// Writes the lines of in to out in the order of compareViews(), holding
+// roughly budget bytes of lines in memory at a time. The input is streamed
+// into runs that fit the budget; each run is sorted with sorter, or with
+// sortList() if sorter is NULL, and, unless it is the only one, appended to
+// a temporary file in $TMPDIR (or /tmp). Spilled runs are then merged with a
+// heap, up to MERGE_FAN at a time, into a second such file and back, so no
+// more than two temporary files are ever open. The read buffers of a merge
+// share the budget too, each of at least 4 KB, so a small budget merges
+// fewer runs at once, in more passes. With threads above 1 each run is
+// sorted by parallelSort() instead, which uses sorter for its partitions.
+// Fills in *stats and returns 0 on success, or -1 with errno set if a read
+// or write fails.
+// Pre: in != NULL, out != NULL, stats != NULL, threads >= 1
+int externalSort(FILE* in, FILE* out, size_t budget, int threads, LineSorter sorter,
+                 ExternalStats* stats) {
+    if (in == NULL || out == NULL || stats == NULL) {
+        fprintf(stderr, "ExternalSort Error: calling externalSort() on NULL reference\n");
+        exit(EXIT_FAILURE);
+    }
+    BufferObj B = { NULL, 0, 0, NULL, 0, 0 };
+    // share the budget among the read buffers of a merge
+    int fan = MERGE_FAN;
+    size_t buffer = budget / MERGE_FAN;
+    if (buffer < SPILL_BUFFER_MIN) {
+        buffer = SPILL_BUFFER_MIN;
+        fan = (budget / SPILL_BUFFER_MIN > 2 ? (int)(budget / SPILL_BUFFER_MIN) : 2);
+    }
+    if (buffer > SPILL_BUFFER) {
+        buffer = SPILL_BUFFER;
+    }
+    SpillObj S = { NULL, NULL, 0, 0, buffer };
+    SpillObj T = { NULL, NULL, 0, 0, buffer };
+    int status = 0;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t n;
+    stats->runs = 0;
+    stats->passes = 0;
+    stats->spilled = 0;
+
+    //----- Cut the input into sorted runs that fit the budget -----//
+    while ((n = getline(&line, &line_capacity, in)) > 0) {
+        if (B.count > 0 && B.used + n + (B.count + 1) * LINE_OVERHEAD > budget) {
+            if (spillRun(&S, &B, threads, sorter, stats) != 0) {
+                status = -1;
+                break;
+            }
+            stats->runs++;
+        }
+        if (B.used + n > B.capacity) {
+            B.capacity = (B.used + n > 2 * B.capacity ? B.used + n : 2 * B.capacity);
+            B.text = realloc(B.text, B.capacity);
+        }
+        if (B.count == B.view_capacity) {
+            B.view_capacity = (B.view_capacity == 0 ? 1024 : 2 * B.view_capacity);
+            B.view = realloc(B.view, B.view_capacity * sizeof(LineView));
+        }
+        memcpy(B.text + B.used, line, n);
+        B.view[B.count].offset = B.used;
+        B.view[B.count].length = n;
+        B.used += n;
+        B.count++;
+    }
+    free(line);
+    if (status == 0 && ferror(in)) {
+        status = -1;
+    }
+
+    //----- Write a lone run straight out, else spill it too -----//
+    if (status == 0 && B.count > 0) {
+        stats->runs++;
+        if (S.count == 0) {
+            emitBuffer(&B, out, 0, threads, sorter, stats);
+        }
+        else {
+            status = spillRun(&S, &B, threads, sorter, stats);
+        }
+    }
+    free(B.text);
+    free(B.view);
+
+    //----- Merge fan runs at a time down to the output -----//
+    while (status == 0 && S.count > fan) {
+        stats->passes++;
+        if (T.file == NULL && (T.file = openSpill(T.buffer)) == NULL) {
+            status = -1;
+            break;
+        }
+        int merged = (S.count + fan - 1) / fan;
+        if (merged + 1 > T.capacity) {
+            T.capacity = merged + 1;
+            T.bound = realloc(T.bound, T.capacity * sizeof(off_t));
+        }
+        rewind(T.file);
+        T.bound[0] = 0;
+        T.count = 0;
+        for (int i = 0; i < S.count && status == 0; i += fan) {
+            int k = (S.count - i < fan ? S.count - i : fan);
+            status = mergeSpills(&S, i, k, T.file, 1, stats);
+            if (status == 0 && (fflush(T.file) != 0 || (T.bound[++T.count] = ftello(T.file)) < 0)) {
+                status = -1;
+            }
+        }
+        SpillObj swap = S;
+        S = T;
+        T = swap;
+    }
+    if (status == 0 && S.count > 0) {
+        stats->passes++;
+        status = mergeSpills(&S, 0, S.count, out, 0, stats);
+    }
+    if (S.file != NULL) fclose(S.file);
+    if (T.file != NULL) fclose(T.file);
+    free(S.bound);
+    free(T.bound);
+    if (status == 0 && ferror(out)) {
+        status = -1;
+    }
+    return status;
+}
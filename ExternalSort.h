@@ -0,0 +1,35 @@
+/*
+ * File:   ExternalSort.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ */
+
+#include<stdio.h>
+#include "Lines.h"
+
+// Exported types -------------------------------------------------------------
+
+// What an externalSort() call did, for reporting.
+typedef struct ExternalStats {
+    long runs;          // sorted runs the input was cut into
+    long passes;        // merge passes over spilled runs
+    long long spilled;  // bytes written to temporary files
+} ExternalStats;
+
+// Other operations -----------------------------------------------------------
+
+// externalSort()
+// Writes the lines of in to out in the order of compareViews(), holding
+// roughly budget bytes of lines in memory at a time. The input is streamed
+// into runs that fit the budget; each run is sorted with sorter, or with
+// sortList() if sorter is NULL, and, unless it is the only one, appended to
+// a temporary file in $TMPDIR (or /tmp). Spilled runs are then merged with a
+// heap, up to MERGE_FAN at a time, into a second such file and back, so no
+// more than two temporary files are ever open. The read buffers of a merge
+// share the budget too, each of at least 4 KB, so a small budget merges
+// fewer runs at once, in more passes. With threads above 1 each run is
+// sorted by parallelSort() instead, which uses sorter for its partitions.
+// Fills in *stats and returns 0 on success, or -1 with errno set if a read
+// or write fails.
+// Pre: in != NULL, out != NULL, stats != NULL, threads >= 1
+int externalSort(FILE* in, FILE* out, size_t budget, int threads, LineSorter sorter,
+                 ExternalStats* stats);
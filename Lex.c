@@ -4,73 +4,252 @@
  *
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
-#include "List.h"
+#include<errno.h>
+#include<limits.h>
+#include<unistd.h>
+#include<getopt.h>
+#include "Lines.h"
+#include "ExternalSort.h"
+#include "ParallelSort.h"
+#include "StringSort.h"
+#include "LineSelect.h"
+#include "ListTemplate.h"
+#include "Writer.h"
+
+#define USAGE "Usage: Lex [-j threads] [-m budget[k|M|G]] [-s list|radix] [--top K] [--unique] <input file> <output file>\n"
+
+// Long options, each with the short option it stands for.
+static const struct option long_options[] = {
+	{ "top", required_argument, NULL, 't' },
+	{ "unique", no_argument, NULL, 'u' },
+	{ NULL, 0, NULL, 0 }
+};
+
+// Lists of line views, so that sorting compares lines without going
+// through an index.
+DEFINE_LIST(ViewList, LineView)
+
+// parseSize()
+// Returns the byte count written in s, a number with an optional k, M or G
+// suffix, or 0 if s is not one.
+size_t parseSize(const char* s) {
+	char* end;
+	errno = 0;
+	unsigned long long n = strtoull(s, &end, 10);
+	if (errno != 0 || end == s) {
+		return 0;
+	}
+	switch (*end) {
+		case 'k': case 'K': n <<= 10; end++; break;
+		case 'm': case 'M': n <<= 20; end++; break;
+		case 'g': case 'G': n <<= 30; end++; break;
+	}
+	return (*end == '\0' ? (size_t)n : 0);
+}
+
+// parseCount()
+// Returns the count written in s, a decimal number from 0 to INT_MAX, or -1
+// if s is not one.
+int parseCount(const char* s) {
+	char* end;
+	errno = 0;
+	long n = strtol(s, &end, 10);
+	if (errno == ERANGE || end == s || *end != '\0' || n < 0 || n > INT_MAX) {
+		return -1;
+	}
+	return (int)n;
+}
+
+// finishOutput()
+// Frees W and closes output, exiting if any write to them failed.
+void finishOutput(Writer W, FILE* output) {
+	if (freeWriter(&W) != 0 || fclose(output) != 0) {
+		perror("Lex Error: writing output failed");
+		exit(EXIT_FAILURE);
+	}
+}
 
-#define MAX_LEN 1000
+// sortExternal()
+// Sorts the file named in into the file named out within budget bytes of
+// memory with sorter on threads workers, reporting what it spilled to stderr.
+void sortExternal(const char* in, const char* out, size_t budget, int threads, LineSorter sorter) {
+	FILE* input = (strcmp(in, "-") == 0 ? stdin : fopen(in, "r"));
+	if (input == NULL) {
+		fprintf(stderr, "File Error: input file does not exist\n");
+		exit(EXIT_FAILURE);
+	}
+	FILE* output = fopen(out, "w");
+	if (output == NULL) {
+		fprintf(stderr, "File Error: output file does not exist\n");
+		exit(EXIT_FAILURE);
+	}
+	ExternalStats stats;
+	if (externalSort(input, output, budget, threads, sorter, &stats) != 0) {
+		perror("Lex Error: external sort failed");
+		exit(EXIT_FAILURE);
+	}
+	if (fclose(output) != 0) {
+		perror("Lex Error: writing output failed");
+		exit(EXIT_FAILURE);
+	}
+	if (input != stdin) {
+		fclose(input);
+	}
+	fprintf(stderr, "Lex: %ld runs, %lld bytes spilled, %ld merge passes\n",
+		stats.runs, stats.spilled, stats.passes);
+}
 
 int main(int argc, char* argv[]) {
-	if (argc != 3) {
+	size_t budget = 0;
+	int threads = 1;
+	int top = -1;
+	int unique = 0;
+	LineSorter sorter = NULL;
+	int opt;
+	while ((opt = getopt_long(argc, argv, "j:m:s:", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'j':
+				threads = parseCount(optarg);
+				if (threads < 1) {
+					fprintf(stderr, "Error: invalid thread count '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'm':
+				budget = parseSize(optarg);
+				if (budget == 0) {
+					fprintf(stderr, "Error: invalid memory budget '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 's':
+				if (strcmp(optarg, "list") == 0) {
+					sorter = NULL;
+				}
+				else if (strcmp(optarg, "radix") == 0) {
+					sorter = radixSort;
+				}
+				else {
+					fprintf(stderr, "Error: invalid sort engine '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 't':
+				top = parseCount(optarg);
+				if (top < 0) {
+					fprintf(stderr, "Error: invalid line count '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'u':
+				unique = 1;
+				break;
+			default:
+				fprintf(stderr, USAGE);
+				exit(EXIT_FAILURE);
+		}
+	}
+	if (argc - optind != 2) {
 		fprintf(stderr, "Error: two command line arguments required\n");
+		fprintf(stderr, USAGE);
 		exit(EXIT_FAILURE);
 	}
+	if (budget > 0 && (top >= 0 || unique)) {
+		fprintf(stderr, "Error: -m cannot be combined with --top or --unique\n");
+		exit(EXIT_FAILURE);
+	}
+	if (budget > 0) {
+		sortExternal(argv[optind], argv[optind + 1], budget, threads, sorter);
+		return 0;
+	}
 	int line_count;
-	FILE* input;
+	Lines input;
 	FILE* output;
-	int i = 0, j = 0;
-	char line[MAX_LEN];
-	input = fopen(argv[1], "r");
+	Writer out;
+	int i = 0;
+	input = readLines(argv[optind]);
 	if (input == NULL) {
 		fprintf(stderr, "File Error: input file does not exist\n");
 		exit(EXIT_FAILURE);
 	}
-	output = fopen(argv[2], "w");
+	output = fopen(argv[optind + 1], "w");
 	if (output == NULL) {
 		fprintf(stderr, "File Error: output file does not exist\n");
 		exit(EXIT_FAILURE);
 	}
-	line_count = 0;
+	// lines are written in place from the input text, gathered by writev()
+	out = newWriter(output);
 
-	//------ Line counting + Placing indices into array -------//
-	while (fgets(line, MAX_LEN, input)) {
-		line_count++;
-	}
-	fseek(input, 0, SEEK_SET);
-	char lines[line_count][MAX_LEN];
-	while (fgets(line, MAX_LEN, input) != NULL) {
-		strcpy(lines[i], line);
-		i++;
-	}
-	fclose(input);
-	List A = newList();
-	append(A, 0);
-	moveFront(A);
+	//----- Top K lines, selected as the text is read --------//
+	// only the views of the lines kept are held, never one for every line
+	if (top >= 0) {
+		const char* text = linesText(input);
+		int n;
+		LineView* best = selectTop(text, linesSize(input), top, unique, &n);
+		for (i = 0; i < n; i++) {
+			writeView(out, text + best[i].offset, best[i].length);
+		}
+		finishOutput(out, output);
+		free(best);
+		freeLines(&input);
+		return 0;
+	}
+
+	//------ Line views -------//
+	LineTable lines = { linesText(input), lineViews(input) };
+	line_count = lineCount(input);
+
+	//----- Distinct lines --------//
+	// with --unique only the first of every group of equal lines is sorted,
+	// and line_count becomes their number
+	int* order = NULL;
+	if (unique) {
+		order = malloc((line_count > 0 ? line_count : 1) * sizeof(int));
+		line_count = selectUnique(&lines, line_count, order);
+	}
 
 	//----- Sorting Algorithm --------//
-	for (i = 1; i < line_count; i++) {
-		for (j = 0; j < length(A); j++) {
-			if (strcmp(lines[get(A)], lines[i]) > 0) {
-				insertBefore(A, i);
-				break;
+	if (threads > 1 || sorter != NULL) {
+		if (order == NULL) {
+			order = malloc((line_count > 0 ? line_count : 1) * sizeof(int));
+			for (i = 0; i < line_count; i++) {
+				order[i] = i;
 			}
-			if (index(A) == length(A) - 1) {
-				append(A, i);
-				break;
-			}
-			moveNext(A);
 		}
-		moveFront(A);
+		if (threads > 1) {
+			parallelSort(&lines, order, line_count, threads, sorter);
+		}
+		else {
+			sorter(&lines, order, line_count);
+		}
+		for (i = 0; i < line_count; i++) {
+			writeView(out, lines.text + lines.view[order[i]].offset, lines.view[order[i]].length);
+		}
+		finishOutput(out, output);
+		free(order);
+		freeLines(&input);
+		return 0;
+	}
+	ViewList A = newViewList();
+	for (i = 0; i < line_count; i++) {
+		appendViewList(A, lines.view[order != NULL ? order[i] : i]);
 	}
-	moveFront(A);
+	sortViewList(A, compareLineViews, (void*)lines.text);
+	moveFrontViewList(A);
 
-	//----- Printing based on indices of sorted array ------//
-	while (index(A) >= 0) {
-		i = get(A);
-		fprintf(output, "%s", lines[i]);
-		moveNext(A);
-	}
-	freeList(&A);
-	fclose(output);
+	//----- Printing the sorted line views ------//
+	while (indexViewList(A) >= 0) {
+		LineView v = getViewList(A);
+		writeView(out, lines.text + v.offset, v.length);
+		moveNextViewList(A);
+	}
+	finishOutput(out, output);
+	freeViewList(&A);
+	free(order);
+	freeLines(&input);
 }
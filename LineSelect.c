@@ -0,0 +1,297 @@
+/*
+ * File:   LineSelect.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include "LineSelect.h"
+
+// Fewest slots of a LineSet.
+#define SET_MIN_SLOTS 16
+
+// Slots of line views selectTop() starts with, unless k needs fewer.
+#define TOP_MIN_SLOTS 1024
+
+// private SlotObj type
+// A slot of a LineSet: a line index plus one, or 0 when empty, next to the
+// hash of its line, so that a probe touches one cache line.
+typedef struct SlotObj {
+    int line;
+    uint32_t hash;
+} SlotObj;
+
+// private LineSetObj type
+// A hash set of line indices, by the text of their lines, with linear
+// probing. The slots double whenever they would be more than half full, so
+// that the set stays as small, and as cache friendly, as it can.
+typedef struct LineSetObj {
+    SlotObj* slot;
+    size_t mask;
+    size_t count;
+} LineSetObj;
+
+// Private functions ----------------------------------------------------------
+
+// hashLine()
+// Returns a hash of the text of line i of T, taken 8 bytes at a time.
+static uint32_t hashLine(const LineTable* T, int i) {
+    const char* p = T->text + T->view[i].offset;
+    size_t n = T->view[i].length;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+    uint64_t w;
+    for (; n >= 8; p += 8, n -= 8) {
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+    }
+    w = 0;
+    memcpy(&w, p, n);
+    h = (h ^ w) * 0xc4ceb9fe1a85ec53ULL;
+    return (uint32_t)(h >> 32);
+}
+
+// sameLine()
+// Returns true (1) iff lines i and j of T hold the same text.
+static int sameLine(const LineTable* T, int i, int j) {
+    LineView a = T->view[i];
+    LineView b = T->view[j];
+    return a.length == b.length && memcmp(T->text + a.offset, T->text + b.offset, a.length) == 0;
+}
+
+// lineBefore()
+// Returns true (1) iff line i of T goes before line j in the order of
+// compareViews().
+static int lineBefore(const LineTable* T, int i, int j) {
+    return compareViews(T->text, T->view[i], T->view[j]) < 0;
+}
+
+// initSet()
+// Makes S an empty LineSet with room for n lines before it must grow.
+static void initSet(LineSetObj* S, size_t n) {
+    size_t slots = SET_MIN_SLOTS;
+    while (slots < 2 * n) {
+        slots *= 2;
+    }
+    S->slot = calloc(slots, sizeof(SlotObj));
+    S->mask = slots - 1;
+    S->count = 0;
+}
+
+// freeSet()
+// Frees the memory held by S.
+static void freeSet(LineSetObj* S) {
+    free(S->slot);
+}
+
+// findLine()
+// Returns the slot of S holding a line of T with the text of line i, whose
+// hash is h, or the empty slot where line i would go.
+static size_t findLine(const LineTable* T, const LineSetObj* S, int i, uint32_t h) {
+    size_t s = h & S->mask;
+    while (S->slot[s].line != 0 && (S->slot[s].hash != h || !sameLine(T, S->slot[s].line - 1, i))) {
+        s = (s + 1) & S->mask;
+    }
+    return s;
+}
+
+// growSet()
+// Doubles the slots of S, moving every line by its stored hash.
+static void growSet(LineSetObj* S) {
+    LineSetObj old = *S;
+    initSet(S, old.mask + 1);
+    for (size_t s = 0; s <= old.mask; s++) {
+        if (old.slot[s].line != 0) {
+            size_t t = old.slot[s].hash & S->mask;
+            while (S->slot[t].line != 0) {
+                t = (t + 1) & S->mask;
+            }
+            S->slot[t] = old.slot[s];
+        }
+    }
+    S->count = old.count;
+    freeSet(&old);
+}
+
+// addLine()
+// Adds line i of T to S and returns true (1), or returns false (0) if S
+// already holds a line with the same text.
+static int addLine(const LineTable* T, LineSetObj* S, int i) {
+    uint32_t h = hashLine(T, i);
+    size_t s = findLine(T, S, i, h);
+    if (S->slot[s].line != 0) {
+        return 0;
+    }
+    if (2 * (S->count + 1) > S->mask + 1) {
+        growSet(S);
+        s = findLine(T, S, i, h);
+    }
+    S->slot[s].line = i + 1;
+    S->slot[s].hash = h;
+    S->count++;
+    return 1;
+}
+
+// removeLine()
+// Removes line i of T, which it holds, from S. The lines after it in its
+// probe run are shifted back, so no slot is left marked deleted.
+static void removeLine(const LineTable* T, LineSetObj* S, int i) {
+    size_t hole = findLine(T, S, i, hashLine(T, i));
+    S->slot[hole].line = 0;
+    S->count--;
+    for (size_t s = (hole + 1) & S->mask; S->slot[s].line != 0; s = (s + 1) & S->mask) {
+        // a line may fill the hole unless its home slot lies after the hole
+        size_t home = S->slot[s].hash & S->mask;
+        if (((s - home) & S->mask) >= ((s - hole) & S->mask)) {
+            S->slot[hole] = S->slot[s];
+            S->slot[s].line = 0;
+            hole = s;
+        }
+    }
+}
+
+// siftUp()
+// Restores the max-heap order of heap after a line was put at pos.
+static void siftUp(const LineTable* T, int* heap, int pos) {
+    int x = heap[pos];
+    while (pos > 0 && lineBefore(T, heap[(pos - 1) / 2], x)) {
+        heap[pos] = heap[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+    heap[pos] = x;
+}
+
+// siftDown()
+// Restores the max-heap order of the first n entries of heap after a line
+// was put at pos.
+static void siftDown(const LineTable* T, int* heap, int n, int pos) {
+    int x = heap[pos];
+    for (;;) {
+        int c = 2 * pos + 1;
+        if (c >= n) {
+            break;
+        }
+        if (c + 1 < n && lineBefore(T, heap[c], heap[c + 1])) {
+            c++;
+        }
+        if (!lineBefore(T, x, heap[c])) {
+            break;
+        }
+        heap[pos] = heap[c];
+        pos = c;
+    }
+    heap[pos] = x;
+}
+
+// Other operations -----------------------------------------------------------
+
+// selectTop()
+// Returns a new array, which the caller frees, of views of the k least lines
+// in the size bytes of text, or of all of them if there are fewer, in the
+// order of compareViews(), and stores how many it holds in *pCount. With
+// unique set, only distinct lines count.
+// Pre: text != NULL if size > 0, pCount != NULL, k >= 0
+LineView* selectTop(const char* text, size_t size, int k, int unique, int* pCount) {
+    if ((text == NULL && size > 0) || pCount == NULL) {
+        fprintf(stderr, "LineSelect Error: calling selectTop() on NULL reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if (k < 0) {
+        fprintf(stderr, "LineSelect Error: calling selectTop() with negative size\n");
+        exit(EXIT_FAILURE);
+    }
+    // every line read goes into a slot of view; heap is a max-heap of the
+    // slots of the least lines so far, its root the greatest, and the one
+    // slot outside it holds the line being read; capacity is a size_t, as
+    // k + 1 slots do not fit in an int when k is INT_MAX
+    size_t capacity = (k < TOP_MIN_SLOTS ? (size_t)k + 1 : TOP_MIN_SLOTS);
+    LineView* view = malloc(capacity * sizeof(LineView));
+    int* heap = malloc(capacity * sizeof(int));
+    LineTable T = { text, view };
+    LineSetObj S;
+    if (unique) {
+        initSet(&S, capacity - 1);
+    }
+    int count = 0;
+    int spare = 0;
+    size_t start = 0;
+    while (start < size) {
+        const char* nl = memchr(text + start, '\n', size - start);
+        size_t end = (nl != NULL ? (size_t)(nl - text) + 1 : size);
+        view[spare].offset = start;
+        view[spare].length = end - start;
+        start = end;
+        if (count < k) {
+            if (!unique || addLine(&T, &S, spare)) {
+                heap[count] = spare;
+                siftUp(&T, heap, count++);
+                spare = count;
+                if ((size_t)spare == capacity) {
+                    capacity = (capacity > (size_t)k / 2 ? (size_t)k + 1 : 2 * capacity);
+                    view = realloc(view, capacity * sizeof(LineView));
+                    heap = realloc(heap, capacity * sizeof(int));
+                    T.view = view;
+                }
+            }
+        }
+        else if (k > 0 && lineBefore(&T, spare, heap[0])) {
+            if (unique) {
+                if (!addLine(&T, &S, spare)) {
+                    continue;
+                }
+                removeLine(&T, &S, heap[0]);
+            }
+            int t = heap[0];
+            heap[0] = spare;
+            spare = t;
+            siftDown(&T, heap, count, 0);
+        }
+    }
+    if (unique) {
+        freeSet(&S);
+    }
+    // heap sort: move the greatest left to the end of the shrinking heap
+    for (int m = count - 1; m > 0; m--) {
+        int t = heap[0];
+        heap[0] = heap[m];
+        heap[m] = t;
+        siftDown(&T, heap, m, 0);
+    }
+    LineView* top = malloc((count > 0 ? count : 1) * sizeof(LineView));
+    for (int i = 0; i < count; i++) {
+        top[i] = view[heap[i]];
+    }
+    free(view);
+    free(heap);
+    *pCount = count;
+    return top;
+}
+
+// selectUnique()
+// Writes to order, in input order, the index of the first of every group of
+// equal lines among the first n lines of table, and returns how many it
+// wrote.
+// Pre: table != NULL, n >= 0, order has room for n indices
+int selectUnique(const LineTable* table, int n, int* order) {
+    if (table == NULL || order == NULL) {
+        fprintf(stderr, "LineSelect Error: calling selectUnique() on NULL reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if (n < 0) {
+        fprintf(stderr, "LineSelect Error: calling selectUnique() with negative size\n");
+        exit(EXIT_FAILURE);
+    }
+    LineSetObj S;
+    initSet(&S, 0);
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        if (addLine(table, &S, i)) {
+            order[count++] = i;
+        }
+    }
+    freeSet(&S);
+    return count;
+}
@@ -0,0 +1,27 @@
+/*
+ * File:   LineSelect.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ */
+
+#include "Lines.h"
+
+// Other operations -----------------------------------------------------------
+
+// selectTop()
+// Returns a new array, which the caller frees, of views of the k least lines
+// in the size bytes of text, or of all of them if there are fewer, in the
+// order of compareViews(), and stores how many it holds in *pCount. With
+// unique set, lines equal to one already chosen are passed over, so the k
+// least distinct lines are chosen. The lines are found in text as they are
+// read, without first indexing them all, and kept in a max-heap of k views,
+// plus a hash set of the lines in it with unique, so this takes O(n log k)
+// time and O(k) memory besides the text.
+// Pre: text != NULL if size > 0, pCount != NULL, k >= 0
+LineView* selectTop(const char* text, size_t size, int k, int unique, int* pCount);
+
+// selectUnique()
+// Writes to order, in input order, the index of the first of every group of
+// equal lines among the first n lines of table, and returns how many it
+// wrote. Lines are told apart with a hash set of line indices.
+// Pre: table != NULL, n >= 0, order has room for n indices
+int selectUnique(const LineTable* table, int n, int* order);
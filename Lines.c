@@ -0,0 +1,204 @@
+/*
+ * File:   Lines.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<errno.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include "Lines.h"
+
+// Inputs that cannot be mapped are read in pieces of READ_CHUNK bytes or
+// more, into a buffer that doubles as it fills.
+#define READ_CHUNK 65536
+
+// private LinesObj type
+typedef struct LinesObj {
+    char* text;
+    size_t size;
+    int mapped;     // text is a mapping of the input, not a heap buffer
+    LineView* view;
+    size_t count;
+} LinesObj;
+
+// readAll()
+// Reads fd to end of file into a new heap buffer, storing its size in
+// *pSize. Returns NULL on a read error.
+static char* readAll(int fd, size_t* pSize) {
+    size_t size = 0;
+    size_t capacity = READ_CHUNK;
+    char* buf = malloc(capacity);
+    for (;;) {
+        if (capacity - size < READ_CHUNK) {
+            capacity *= 2;
+            buf = realloc(buf, capacity);
+        }
+        ssize_t n = read(fd, buf + size, capacity - size);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            free(buf);
+            return NULL;
+        }
+        size += n;
+    }
+    *pSize = size;
+    return buf;
+}
+
+// scanLines()
+// Fills in the line views of T from its text in a single pass.
+static void scanLines(Lines T) {
+    size_t capacity = 1024;
+    size_t start = 0;
+    T->view = malloc(capacity * sizeof(LineView));
+    T->count = 0;
+    while (start < T->size) {
+        const char* nl = memchr(T->text + start, '\n', T->size - start);
+        size_t end = (nl != NULL ? (size_t)(nl - T->text) + 1 : T->size);
+        if (T->count == capacity) {
+            capacity *= 2;
+            T->view = realloc(T->view, capacity * sizeof(LineView));
+        }
+        T->view[T->count].offset = start;
+        T->view[T->count].length = end - start;
+        T->count++;
+        start = end;
+    }
+}
+
+// Constructors-Destructors ---------------------------------------------------
+
+// readLines()
+// Returns reference to a new Lines object holding the contents of the file
+// named path, or of stdin if path is "-". Regular files are memory mapped;
+// anything else is read into memory in one buffer. Lines may be of any
+// length. The line views are only found by the first call of lineCount()
+// or lineViews(). Returns NULL, with errno set, if the input cannot be
+// read.
+Lines readLines(const char* path) {
+    int fd = (strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY));
+    if (fd < 0) {
+        return NULL;
+    }
+    Lines T = malloc(sizeof(LinesObj));
+    T->text = NULL;
+    T->size = 0;
+    T->mapped = 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            T->text = p;
+            T->size = st.st_size;
+            T->mapped = 1;
+        }
+    }
+    if (!T->mapped) {
+        T->text = readAll(fd, &T->size);
+    }
+    if (fd != STDIN_FILENO) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+    }
+    if (T->text == NULL) {
+        free(T);
+        return NULL;
+    }
+    T->view = NULL;
+    T->count = 0;
+    return(T);
+}
+
+// freeLines()
+// Frees all memory associated with Lines *pT, and sets *pT to NULL.
+// Pre: Lines != NULL
+void freeLines(Lines* pT) {
+    if (pT == NULL || *pT == NULL) {
+        fprintf(stderr, "Lines Error: calling freeLines() on NULL Lines reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((*pT)->mapped) {
+        munmap((*pT)->text, (*pT)->size);
+    }
+    else {
+        free((*pT)->text);
+    }
+    free((*pT)->view);
+    free(*pT);
+    *pT = NULL;
+}
+
+// Access functions -----------------------------------------------------------
+
+// lineCount()
+// Returns the number of lines in T, finding them on the first call.
+// Pre: Lines != NULL
+size_t lineCount(Lines T) {
+    if (T == NULL) {
+        fprintf(stderr, "Lines Error: calling lineCount() on NULL Lines reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if (T->view == NULL) {
+        scanLines(T);
+    }
+    return T->count;
+}
+
+// linesText()
+// Returns the text of T that its line views point into.
+// Pre: Lines != NULL
+const char* linesText(Lines T) {
+    if (T == NULL) {
+        fprintf(stderr, "Lines Error: calling linesText() on NULL Lines reference\n");
+        exit(EXIT_FAILURE);
+    }
+    return T->text;
+}
+
+// linesSize()
+// Returns the number of bytes in the text of T.
+// Pre: Lines != NULL
+size_t linesSize(Lines T) {
+    if (T == NULL) {
+        fprintf(stderr, "Lines Error: calling linesSize() on NULL Lines reference\n");
+        exit(EXIT_FAILURE);
+    }
+    return T->size;
+}
+
+// lineViews()
+// Returns the array of lineCount(T) line views of T, in input order,
+// finding them on the first call.
+// Pre: Lines != NULL
+const LineView* lineViews(Lines T) {
+    if (T == NULL) {
+        fprintf(stderr, "Lines Error: calling lineViews() on NULL Lines reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if (T->view == NULL) {
+        scanLines(T);
+    }
+    return T->view;
+}
+
+// Other operations -----------------------------------------------------------
+
+// compareLines()
+// Orders line indices i and j by the lines they refer to in the LineTable
+// ctx, as compareViews() does. Suitable as a sortList() comparison function.
+int compareLines(int i, int j, void* ctx) {
+    LineTable* T = ctx;
+    return compareViews(T->text, T->view[i], T->view[j]);
+}
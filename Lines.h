@@ -0,0 +1,101 @@
+/*
+ * File:   Lines.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ */
+
+#ifndef LINES_H_INCLUDE_
+#define LINES_H_INCLUDE_
+
+#include<stddef.h>
+#include<string.h>
+
+// Exported types -------------------------------------------------------------
+
+// A Lines object holds the whole text of an input and a view of every line
+// in it. Each view is an offset and length into that text and includes the
+// line's terminating newline, if it has one.
+typedef struct LinesObj* Lines;
+
+typedef struct LineView {
+    size_t offset;
+    size_t length;
+} LineView;
+
+// A LineTable pairs a text with views into it, for compareLines().
+typedef struct LineTable {
+    const char* text;
+    const LineView* view;
+} LineTable;
+
+// A LineSorter sorts n line indices in order by the lines they refer to in
+// a LineTable, into the order of compareViews().
+typedef void (*LineSorter)(const LineTable* table, int* order, int n);
+
+// Constructors-Destructors ---------------------------------------------------
+
+// readLines()
+// Returns reference to a new Lines object holding the contents of the file
+// named path, or of stdin if path is "-". Regular files are memory mapped;
+// anything else is read into memory in one buffer. Lines may be of any
+// length. The line views are only found by the first call of lineCount()
+// or lineViews(). Returns NULL, with errno set, if the input cannot be
+// read.
+Lines readLines(const char* path);
+
+// freeLines()
+// Frees all memory associated with Lines *pT, and sets *pT to NULL.
+// Pre: Lines != NULL
+void freeLines(Lines* pT);
+
+// Access functions -----------------------------------------------------------
+
+// lineCount()
+// Returns the number of lines in T, finding them on the first call.
+// Pre: Lines != NULL
+size_t lineCount(Lines T);
+
+// linesText()
+// Returns the text of T that its line views point into.
+// Pre: Lines != NULL
+const char* linesText(Lines T);
+
+// linesSize()
+// Returns the number of bytes in the text of T.
+// Pre: Lines != NULL
+size_t linesSize(Lines T);
+
+// lineViews()
+// Returns the array of lineCount(T) line views of T, in input order,
+// finding them on the first call.
+// Pre: Lines != NULL
+const LineView* lineViews(Lines T);
+
+// Other operations -----------------------------------------------------------
+
+// compareViews()
+// Compares lines a and b of text byte by byte as unsigned chars, a shorter
+// line ordering before any line it is a prefix of. This is the order strcmp()
+// gives lines that contain no NUL bytes. Defined here so that sort loops
+// can inline it.
+static inline int compareViews(const char* text, LineView a, LineView b) {
+    size_t n = (a.length < b.length ? a.length : b.length);
+    int c = memcmp(text + a.offset, text + b.offset, n);
+    if (c != 0) {
+        return c;
+    }
+    return (a.length > b.length) - (a.length < b.length);
+}
+
+// compareLineViews()
+// Orders line views a and b of the text ctx, as compareViews() does.
+// Suitable as the comparison function of a List of LineViews.
+static inline int compareLineViews(LineView a, LineView b, void* ctx) {
+    return compareViews(ctx, a, b);
+}
+
+// compareLines()
+// Orders line indices i and j by the lines they refer to in the LineTable
+// ctx, as compareViews() does. Suitable as a sortList() comparison function.
+int compareLines(int i, int j, void* ctx);
+
+#endif
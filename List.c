@@ -4,28 +4,296 @@
  *
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include<stdio.h>
 #include<stdlib.h>
+#include<string.h>
+#include<limits.h>
+#include<stdint.h>
+#include<assert.h>
+#include<pthread.h>
 #include "List.h"
+#include "ListInline.h"
+#include "ListPack.h"
+#include "Writer.h"
+#include "ListStats.h"
 
- // private NodeObj type
-typedef struct NodeObj {
-    int data;
-    struct NodeObj* next;
-    struct NodeObj* prev;
-} NodeObj;
+#ifdef LIST_INDEX
+
+// private Node type
+// The position of a node in the array of its pool, NODE_NIL for none.
+typedef uint32_t Node;
+
+// Nodes are carved out of one array owned by a pool, see ListInline.h. It
+// first holds POOL_MIN_CHUNK nodes and grows by half when it fills up.
+#define POOL_MIN_CHUNK 16
+
+// POOL_NODE()
+// The node at position i of the array of P.
+#define POOL_NODE(P, i) ((Node)(i))
+
+#else
 
 // private Node type
 typedef NodeObj* Node;
 
-// private ListObj type
-typedef struct ListObj {
-    Node front;
-    Node back;
-    Node cursor;
-    int length;
-    int cursor_index;
-} ListObj;
+// Nodes are carved out of chunks owned by a pool. The first chunk holds
+// POOL_MIN_CHUNK nodes and each later one doubles, up to POOL_MAX_CHUNK.
+#define POOL_MIN_CHUNK 16
+#define POOL_MAX_CHUNK 4096
+
+// POOL_NODE()
+// The node at position i of the newest chunk of P.
+#define POOL_NODE(P, i) (&(P)->chunks->nodes[i])
+
+// private ChunkObj type
+typedef struct ChunkObj {
+    struct ChunkObj* next;
+    NodeObj nodes[];
+} ChunkObj;
+
+// private Chunk type
+typedef ChunkObj* Chunk;
+
+// private PoolObj type
+typedef struct PoolObj {
+    Chunk chunks;   // every chunk owned by the pool, newest first
+    Chunk oldest;   // last chunk of chunks
+    Node free;      // recycled nodes, linked through next
+    Node free_last; // last node of free, if free is not NULL
+    int used;       // nodes handed out from the newest chunk
+    int size;       // capacity of the newest chunk
+    int refs;       // number of Lists drawing nodes from the pool
+} PoolObj;
+
+#endif
+
+// private Pool type
+typedef PoolObj* Pool;
+
+// The positional skip index has at most SKIP_MAX_LEVEL levels above the
+// node chain; a node gets a tower one level taller with probability 1/4.
+// Cursor moves of at most SKIP_WALK steps are walked instead of searched.
+#define SKIP_MAX_LEVEL 16
+#define SKIP_WALK 32
+
+// private TowerObj type
+// An entry of the positional skip index standing over one node. link[k]
+// leads to the next tower that reaches level k, width nodes further on.
+typedef struct TowerObj {
+    Node node;
+    int height;
+    struct {
+        struct TowerObj* next;
+        int width;
+    } link[];
+} TowerObj;
+
+// private Tower type
+typedef TowerObj* Tower;
+
+// private ShareObj type
+// Counts the Lists holding one chain of nodes, after copyList() has handed
+// out snapshots of it. Whichever changes the chain first copies it.
+typedef struct ShareObj {
+    int refs;
+} ShareObj;
+
+// private ListIterObj type
+typedef struct ListIterObj {
+    List list;
+    Node node;          // element under the iterator, NULL if undefined
+    int index;          // -1 if undefined
+    unsigned version;   // version of list when the traversal began
+    int decoded;        // block of a compact list held in buffer, -1 if none
+    int* buffer;        // PACK_BLOCK decoded elements, NULL until needed
+} ListIterObj;
+
+// private LockObj type
+// The reader-writer lock of a List. Waiting writers go first, so that a
+// steady stream of readers cannot starve them, which pthread_rwlock_t
+// allows on glibc.
+typedef struct LockObj {
+    pthread_mutex_t mutex;
+    pthread_cond_t readable;    // signaled when no writer holds or awaits L
+    pthread_cond_t writable;    // signaled when the lock falls free
+    int readers;                // threads holding a read lock
+    int writers;                // threads holding or awaiting the write lock
+    int writing;                // true (1) while the write lock is held
+} LockObj;
+
+// The lock of a List sits right after its ListObj, in the same allocation,
+// so that ListInline.h and its clients need no POSIX types.
+#define LIST_LOCK(L) ((LockObj*)((L) + 1))
+
+// With LIST_STATS the counters of a List follow its lock.
+#define LIST_COUNTS(L) ((unsigned long long*)(LIST_LOCK(L) + 1))
+
+// FAIL_IF()
+// Reports msg and exits if the precondition failure cond holds. With
+// LIST_UNCHECKED it is only an assert(), which NDEBUG compiles out.
+#ifdef LIST_UNCHECKED
+#define FAIL_IF(cond, msg) assert(!(cond))
+#else
+#define FAIL_IF(cond, msg) do { if (cond) { fputs(msg, stderr); exit(EXIT_FAILURE); } } while (0)
+#endif
+
+#ifdef LIST_SHARED_POOL
+// With LIST_SHARED_POOL every List created on a thread draws from that
+// thread's pool. The extra reference keeps it alive for the whole thread,
+// so such Lists must not be handed to another thread.
+#ifdef LIST_INDEX
+static _Thread_local PoolObj thread_pool = { NULL, 0, 0, 0, 1 };
+#else
+static _Thread_local PoolObj thread_pool = { NULL, NULL, NULL, NULL, 0, 0, 1 };
+#endif
+#endif
+
+// Reference counts -----------------------------------------------------------
+
+// The refs of a pool or share record are counted by every List holding it,
+// and a List and its snapshots from copyList() may each be used on another
+// thread under a lock of its own, so refs are only changed atomically. The
+// last holder is the one whose dropRef() takes the count to zero; one that
+// finds itself the only holder, with soleRef(), may then change what the
+// others let go of, as their changes happen before.
+
+// holdRef()
+// Adds a holder to the count at refs, on behalf of one who holds it already.
+static inline void holdRef(int* refs) {
+    __atomic_fetch_add(refs, 1, __ATOMIC_RELAXED);
+}
+
+// dropRef()
+// Drops a holder from the count at refs. Returns true (1) iff it was the
+// last one.
+static inline int dropRef(int* refs) {
+    return __atomic_fetch_sub(refs, 1, __ATOMIC_ACQ_REL) == 1;
+}
+
+// soleRef()
+// Returns true (1) iff the caller is the only holder counted at refs.
+static inline int soleRef(int* refs) {
+    return __atomic_load_n(refs, __ATOMIC_ACQUIRE) == 1;
+}
+
+// Pool functions -------------------------------------------------------------
+
+// newPool()
+// Returns reference to a new pool holding no chunks.
+Pool newPool(void) {
+#ifdef LIST_SHARED_POOL
+    holdRef(&thread_pool.refs);
+    return &thread_pool;
+#elif defined(LIST_INDEX)
+    Pool P = malloc(sizeof(PoolObj));
+    P->nodes = NULL;
+    P->free = NODE_NIL;
+    P->used = 0;
+    P->size = 0;
+    P->refs = 1;
+    return(P);
+#else
+    Pool P = malloc(sizeof(PoolObj));
+    P->chunks = NULL;
+    P->oldest = NULL;
+    P->free = NULL;
+    P->free_last = NULL;
+    P->used = 0;
+    P->size = 0;
+    P->refs = 1;
+    return(P);
+#endif
+}
+
+// resetPool()
+// Releases every chunk of P at once, invalidating all nodes carved from it.
+void resetPool(Pool P) {
+#ifdef LIST_INDEX
+    free(P->nodes);
+    P->nodes = NULL;
+    P->free = NODE_NIL;
+    P->used = 0;
+    P->size = 0;
+#else
+    Chunk C = P->chunks;
+    while (C != NULL) {
+        Chunk D = C->next;
+        free(C);
+        C = D;
+    }
+    P->chunks = NULL;
+    P->oldest = NULL;
+    P->free = NULL;
+    P->free_last = NULL;
+    P->used = 0;
+    P->size = 0;
+#endif
+}
+
+// releasePool()
+// Drops one reference to *pP, freeing the pool with the last one, and
+// sets *pP to NULL.
+void releasePool(Pool* pP) {
+    if (pP != NULL && *pP != NULL) {
+        if (dropRef(&(*pP)->refs)) {
+            resetPool(*pP);
+            free(*pP);
+        }
+        *pP = NULL;
+    }
+}
+
+#ifndef LIST_INDEX
+
+// mergePool()
+// Moves every chunk and recycled node of Q into P, leaving Q empty. Nodes
+// carved from Q stay valid and now belong to P.
+void mergePool(Pool P, Pool Q) {
+    if (Q->chunks == NULL) {
+        return;
+    }
+    if (P->chunks == NULL) {
+        P->chunks = Q->chunks;
+        P->used = Q->used;
+        P->size = Q->size;
+    }
+    else {
+        P->oldest->next = Q->chunks;
+    }
+    P->oldest = Q->oldest;
+    if (Q->free != NULL) {
+        if (P->free == NULL) {
+            P->free_last = Q->free_last;
+        }
+        Q->free_last->next = P->free;
+        P->free = Q->free;
+    }
+    Q->chunks = NULL;
+    Q->oldest = NULL;
+    Q->free = NULL;
+    Q->free_last = NULL;
+    Q->used = 0;
+    Q->size = 0;
+}
+
+#else
+
+// clonePool()
+// Returns reference to a new pool holding a copy of the node array and
+// free list of Q, every node at the same position.
+Pool clonePool(Pool Q) {
+    Pool P = newPool();
+    P->nodes = malloc((size_t)Q->used * sizeof(NodeObj));
+    memcpy(P->nodes, Q->nodes, (size_t)Q->used * sizeof(NodeObj));
+    P->free = Q->free;
+    P->used = Q->used;
+    P->size = Q->used;
+    return(P);
+}
+
+#endif
 
 // Constructors-Destructors ---------------------------------------------------
 
@@ -33,12 +301,84 @@ typedef struct ListObj {
 // Returns reference to new empty List object.
 List newList(void) {
     List L;
-    L = malloc(sizeof(ListObj));
-    L->front = NULL;
-    L->back = NULL;
-    L->cursor = NULL;
+    L = malloc(sizeof(ListObj) + sizeof(LockObj) + STAT_BYTES);
+    L->front = NODE_NIL;
+    L->back = NODE_NIL;
+    L->cursor = NODE_NIL;
     L->length = 0;
     L->cursor_index = -1;
+    L->pool = newPool();
+    L->skip = NULL;
+    L->skip_seed = 0x9e3779b9;
+    L->share = NULL;
+    L->pack = NULL;
+    L->version = 0;
+    L->hash = 0;
+    L->hash_power = 1;
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_init(&K->mutex, NULL);
+    pthread_cond_init(&K->readable, NULL);
+    pthread_cond_init(&K->writable, NULL);
+    K->readers = 0;
+    K->writers = 0;
+    K->writing = 0;
+    STAT_INIT(L);
+    return(L);
+}
+
+// newListFromArray()
+// Returns reference to new List object holding the n elements of data,
+// in order. The cursor is undefined.
+// Pre: data != NULL if n > 0
+List newListFromArray(const int* data, size_t n) {
+    FAIL_IF(data == NULL && n > 0, "List Error: calling newListFromArray() on NULL array\n");
+    List L = newList();
+    appendArray(L, data, n);
+    return(L);
+}
+
+// newPackedList()
+// Returns reference to new empty List object in compact mode.
+List newPackedList(void) {
+    List L = newList();
+    L->pack = newPack();
+    return(L);
+}
+
+// loadList()
+// Returns reference to new List object holding the elements that
+// saveList() wrote to in, or NULL with errno set.
+// Pre: in != NULL
+List loadList(FILE* in) {
+    FAIL_IF(in == NULL, "File Error: calling loadList() on NULL file pointer\n");
+    STAT_TIME(LIST_OP_IO);
+    int n;
+    int* data = readListFile(in, &n);
+    if (data == NULL) {
+        return NULL;
+    }
+    List L = newListFromArray(data, n);
+    free(data);
+    return(L);
+}
+
+// mapList()
+// Returns reference to new List object over the elements that saveList()
+// wrote to the file named path, read in place from a read-only mapping,
+// or NULL with errno set.
+// Pre: path != NULL
+List mapList(const char* path) {
+    FAIL_IF(path == NULL, "List Error: calling mapList() on NULL path\n");
+    STAT_TIME(LIST_OP_IO);
+    int n;
+    Pack P = mapPack(path, &n);
+    if (P == NULL) {
+        return NULL;
+    }
+    List L = newList();
+    L->pack = P;
+    L->length = n;
+    L->hash_power = 0;
     return(L);
 }
 
@@ -46,14 +386,15 @@ List newList(void) {
 // Frees all heap memory associated with List *pL, and sets *pL to NULL.
 // Pre: List != NULL
 void freeList(List* pL) {
-    if (*pL == NULL) {
-        fprintf(stderr, "List Error: calling freeList() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
+    FAIL_IF(*pL == NULL, "List Error: calling freeList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_DELETE);
     if (pL != NULL && *pL != NULL) {
-        while (length(*pL) != 0) { 
-            deleteFront(*pL);
-        }
+        clear(*pL);
+        releasePool(&(*pL)->pool);
+        freePack(&(*pL)->pack);
+        pthread_mutex_destroy(&LIST_LOCK(*pL)->mutex);
+        pthread_cond_destroy(&LIST_LOCK(*pL)->readable);
+        pthread_cond_destroy(&LIST_LOCK(*pL)->writable);
         free(*pL);
         *pL = NULL;
     }
@@ -61,34 +402,744 @@ void freeList(List* pL) {
 }
 
 // freeNode()
-// Frees heap memory pointed to by *pN, sets *pN to NULL.
-void freeNode(Node* pN) {
-    if (pN != NULL && *pN != NULL) {
-        free(*pN);
-        *pN = NULL;
+// Returns the node pointed to by *pN to the free list of P, sets *pN to
+// NODE_NIL.
+void freeNode(Pool P, Node* pN) {
+    if (pN != NULL && *pN != NODE_NIL) {
+#ifndef LIST_INDEX
+        if (P->free == NULL) {
+            P->free_last = *pN;
+        }
+#endif
+        POOL_AT(P, *pN).next = P->free;
+        P->free = *pN;
+        *pN = NODE_NIL;
     }
 }
 
+#ifdef LIST_INDEX
+
+// growPool()
+// Enlarges the array of P by half, or further to make room for want more
+// nodes. The first array also takes up position 0, which stands for none.
+void growPool(Pool P, int want) {
+    if (P->used == 0) {
+        P->used = 1;
+    }
+    size_t need = (size_t)P->used + want;
+    size_t size = (size_t)P->size + P->size / 2;
+    FAIL_IF(need > UINT32_MAX, "List Error: more nodes in one pool than 32-bit links can reach\n");
+    if (size < POOL_MIN_CHUNK) size = POOL_MIN_CHUNK;
+    if (size < need) size = need;
+    if (size > UINT32_MAX) size = UINT32_MAX;
+    P->nodes = realloc(P->nodes, size * sizeof(NodeObj));
+    P->size = (uint32_t)size;
+}
+
+// mergePool()
+// Moves every node of Q, in use or free, to the end of the array of P,
+// leaving Q empty, and returns how far their positions moved. The links
+// between them move with them and the free nodes of Q join those of P.
+uint32_t mergePool(Pool P, Pool Q) {
+    if (Q->used <= 1) {
+        resetPool(Q);
+        return 0;
+    }
+    uint32_t n = Q->used - 1;
+    if (P->used == 0 || P->size - P->used < n) {
+        growPool(P, (int)n);
+    }
+    uint32_t base = P->used - 1;
+    NodeObj* moved = &P->nodes[P->used];
+    memcpy(moved, &Q->nodes[1], (size_t)n * sizeof(NodeObj));
+    for (uint32_t i = 0; i < n; i++) {
+        if (moved[i].next != NODE_NIL) moved[i].next += base;
+        if (moved[i].prev != NODE_NIL) moved[i].prev += base;
+    }
+    if (Q->free != NODE_NIL) {
+        Node last = Q->free + base;
+        while (POOL_AT(P, last).next != NODE_NIL) {
+            last = POOL_AT(P, last).next;
+        }
+        POOL_AT(P, last).next = P->free;
+        P->free = Q->free + base;
+    }
+    P->used += n;
+    resetPool(Q);
+    return base;
+}
+
+#else
+
+// growPool()
+// Starts a new chunk in P with room for at least want nodes.
+void growPool(Pool P, int want) {
+    int size = P->size * 2;
+    if (size < POOL_MIN_CHUNK) size = POOL_MIN_CHUNK;
+    if (size > POOL_MAX_CHUNK) size = POOL_MAX_CHUNK;
+    if (size < want) size = want;
+    Chunk C = malloc(sizeof(ChunkObj) + (size_t)size * sizeof(NodeObj));
+    C->next = P->chunks;
+    if (P->chunks == NULL) {
+        P->oldest = C;
+    }
+    P->chunks = C;
+    P->used = 0;
+    P->size = size;
+}
+
+#endif
+
 // newNode()
-// Returns reference to new Node object. Initializes next and data fields.
-Node newNode(int data) {
-    Node N = malloc(sizeof(NodeObj));
-    N->data = data;
-    N->next = NULL;
-    N->prev = NULL;
+// Returns reference to new Node object taken from P. Initializes next and
+// data fields.
+Node newNode(Pool P, int data) {
+    Node N;
+    if (P->free != NODE_NIL) {
+        N = P->free;
+        P->free = POOL_AT(P, N).next;
+    }
+    else {
+        if (P->used == P->size) {
+            growPool(P, 1);
+        }
+        N = POOL_NODE(P, P->used++);
+    }
+    POOL_AT(P, N).data = data;
+    POOL_AT(P, N).next = NODE_NIL;
+    POOL_AT(P, N).prev = NODE_NIL;
     return(N);
 }
 
+// newNodes()
+// Returns the first of n > 0 new nodes taken from P and linked in order,
+// and sets *pLast to the last. Recycled nodes are used first; the rest are
+// carved from the newest chunk in one run, after growing the pool once to
+// fit them. Data fields are left to the caller.
+Node newNodes(Pool P, int n, Node* pLast) {
+#ifdef LIST_INDEX
+    // position 0 holds no node, so it can head the chain
+    Node head = NODE_NIL;
+#else
+    NodeObj head_obj;
+    Node head = &head_obj;
+#endif
+    Node last = head;
+    while (n > 0 && P->free != NODE_NIL) {
+        Node N = P->free;
+        P->free = POOL_AT(P, N).next;
+        POOL_AT(P, last).next = N;
+        POOL_AT(P, N).prev = last;
+        last = N;
+        n--;
+    }
+    while (n > 0) {
+        if (P->used == P->size) {
+            growPool(P, n);
+        }
+        int k = P->size - P->used;
+        if (k > n) k = n;
+        for (int i = 0; i < k; i++) {
+            Node M = POOL_NODE(P, P->used + i);
+            POOL_AT(P, last).next = M;
+            POOL_AT(P, M).prev = last;
+            last = M;
+        }
+        P->used += k;
+        n -= k;
+    }
+    POOL_AT(P, last).next = NODE_NIL;
+    POOL_AT(P, POOL_AT(P, head).next).prev = NODE_NIL;
+    *pLast = last;
+    return(POOL_AT(P, head).next);
+}
+
+// Skip index functions -------------------------------------------------------
+
+// The index is an indexable skip list over the nodes of L. It is built the
+// first time a positional lookup needs it and then kept up to date by every
+// insertion and deletion, so moveTo(), getAt() and the positional updates
+// they imply are O(log n). Lists that never seek pay nothing for it.
+
+// newTower()
+// Returns reference to a new Tower over N with room for height levels.
+Tower newTower(Node N, int height) {
+    Tower T = malloc(sizeof(TowerObj) + height * sizeof(T->link[0]));
+    T->node = N;
+    T->height = height;
+    for (int k = 0; k < height; k++) {
+        T->link[k].next = NULL;
+        T->link[k].width = 0;
+    }
+    return(T);
+}
+
+// skipHeight()
+// Returns a random tower height for L, 0 for three nodes in four.
+int skipHeight(List L) {
+    unsigned r = L->skip_seed;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    L->skip_seed = r;
+    int h = 0;
+    while ((r & 3) == 0 && h < SKIP_MAX_LEVEL) {
+        h++;
+        r >>= 2;
+    }
+    return h;
+}
+
+// freeSkip()
+// Frees the positional index of L, if any.
+void freeSkip(List L) {
+    Tower T = L->skip;
+    while (T != NULL) {
+        Tower U = T->link[0].next;
+        free(T);
+        T = U;
+    }
+    L->skip = NULL;
+}
+
+// buildSkip()
+// Builds the positional index of L in a single pass over its nodes.
+void buildSkip(List L) {
+    Tower last[SKIP_MAX_LEVEL];
+    int last_pos[SKIP_MAX_LEVEL];
+    L->skip = newTower(NODE_NIL, SKIP_MAX_LEVEL);
+    L->skip->height = 0;
+    for (int k = 0; k < SKIP_MAX_LEVEL; k++) {
+        last[k] = L->skip;
+        last_pos[k] = 0;
+    }
+    int pos = 0;
+    for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next, pos++) {
+        int h = skipHeight(L);
+        if (h == 0) continue;
+        Tower T = newTower(N, h);
+        for (int k = 0; k < h; k++) {
+            last[k]->link[k].next = T;
+            last[k]->link[k].width = pos - last_pos[k];
+            last[k] = T;
+            last_pos[k] = pos;
+        }
+        if (h > L->skip->height) {
+            L->skip->height = h;
+        }
+    }
+}
+
+// skipPath()
+// Fills update[k] with the last tower reaching level k that lies before
+// position pos, and update_pos[k] with its position.
+void skipPath(List L, int pos, Tower* update, int* update_pos) {
+    Tower T = L->skip;
+    int p = 0;
+    for (int k = L->skip->height - 1; k >= 0; k--) {
+        while (T->link[k].next != NULL && p + T->link[k].width < pos) {
+            p += T->link[k].width;
+            T = T->link[k].next;
+        }
+        update[k] = T;
+        update_pos[k] = p;
+    }
+}
+
+// skipInsert()
+// Records in the index of L that node N was inserted at position pos.
+void skipInsert(List L, int pos, Node N) {
+    Tower update[SKIP_MAX_LEVEL];
+    int update_pos[SKIP_MAX_LEVEL];
+    int h = skipHeight(L);
+    Tower T = (h > 0 ? newTower(N, h) : NULL);
+    while (L->skip->height < h) {
+        L->skip->link[L->skip->height].next = NULL;
+        L->skip->height++;
+    }
+    skipPath(L, pos, update, update_pos);
+    for (int k = 0; k < L->skip->height; k++) {
+        Tower U = update[k];
+        if (k < h) {
+            T->link[k].next = U->link[k].next;
+            T->link[k].width = update_pos[k] + U->link[k].width + 1 - pos;
+            U->link[k].next = T;
+            U->link[k].width = pos - update_pos[k];
+        }
+        else if (U->link[k].next != NULL) {
+            U->link[k].width++;
+        }
+    }
+}
+
+// skipDelete()
+// Records in the index of L that node N at position pos is being deleted.
+void skipDelete(List L, int pos, Node N) {
+    Tower update[SKIP_MAX_LEVEL];
+    int update_pos[SKIP_MAX_LEVEL];
+    Tower T = NULL;
+    skipPath(L, pos, update, update_pos);
+    for (int k = 0; k < L->skip->height; k++) {
+        Tower U = update[k];
+        if (U->link[k].next != NULL && U->link[k].next->node == N) {
+            T = U->link[k].next;
+            U->link[k].width += T->link[k].width - 1;
+            U->link[k].next = T->link[k].next;
+        }
+        else if (U->link[k].next != NULL) {
+            U->link[k].width--;
+        }
+    }
+    free(T);
+}
+
+// locate()
+// Returns the node at position i of L, walking from whichever of the
+// cursor, front and back is close enough, and searching the index otherwise.
+Node locate(List L, int i) {
+    Node N;
+    int p;
+    if (i < SKIP_WALK) {
+        N = L->front;
+        p = 0;
+    }
+    else if (L->length - 1 - i < SKIP_WALK) {
+        N = L->back;
+        p = L->length - 1;
+    }
+    else if (L->cursor_index >= 0 && abs(i - L->cursor_index) < SKIP_WALK) {
+        N = L->cursor;
+        p = L->cursor_index;
+    }
+    else {
+        if (L->skip == NULL) {
+            buildSkip(L);
+        }
+        Tower T = L->skip;
+        p = 0;
+        for (int k = L->skip->height - 1; k >= 0; k--) {
+            while (T->link[k].next != NULL && p + T->link[k].width <= i) {
+                p += T->link[k].width;
+                T = T->link[k].next;
+            }
+        }
+        N = (T->node != NODE_NIL ? T->node : L->front);
+    }
+    STAT_ADD(L, STAT_CURSOR_STEPS, abs(i - p));
+    while (p < i) {
+        N = NODE_AT(L, N).next;
+        p++;
+    }
+    while (p > i) {
+        N = NODE_AT(L, N).prev;
+        p--;
+    }
+    return N;
+}
+
+// Sorted search functions ----------------------------------------------------
+
+// precedes()
+// Returns true (1) iff e comes before the bound of x under cmp: if it is
+// less than x, or not greater than x when strict is true.
+int precedes(int e, int x, int strict, int (*cmp)(int, int, void*), void* ctx) {
+    int c = cmp(e, x, ctx);
+    return (strict ? c <= 0 : c < 0);
+}
+
+// packBound()
+// Returns the position of the first element of the compact List L that
+// does not precede the bound of x, by binary search.
+int packBound(List L, int x, int strict, int (*cmp)(int, int, void*), void* ctx) {
+    int lo = 0;
+    int hi = L->length;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (precedes(packGet(L->pack, mid), x, strict, cmp, ctx)) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// seekBound()
+// Returns the position of the first element of L, sorted under cmp, that
+// does not precede the bound of x, and sets *pN to its node, NULL if there
+// is none. Walks from the cursor when the bound lies within SKIP_WALK
+// elements of it, and otherwise descends the positional index comparing
+// elements, as skip list searches do.
+int seekBound(List L, int x, int strict, int (*cmp)(int, int, void*), void* ctx, Node* pN) {
+    Node N = L->cursor;
+    int p = L->cursor_index;
+    if (N != NODE_NIL) {
+        if (precedes(NODE_AT(L, N).data, x, strict, cmp, ctx)) {
+            for (int s = 0; s < SKIP_WALK; s++) {
+                N = NODE_AT(L, N).next;
+                p++;
+                STAT_ADD(L, STAT_CURSOR_STEPS, 1);
+                if (N == NODE_NIL || !precedes(NODE_AT(L, N).data, x, strict, cmp, ctx)) {
+                    *pN = N;
+                    return p;
+                }
+            }
+        }
+        else {
+            for (int s = 0; s < SKIP_WALK; s++) {
+                if (NODE_AT(L, N).prev == NODE_NIL || precedes(NODE_AT(L, NODE_AT(L, N).prev).data, x, strict, cmp, ctx)) {
+                    *pN = N;
+                    return p;
+                }
+                N = NODE_AT(L, N).prev;
+                p--;
+                STAT_ADD(L, STAT_CURSOR_STEPS, 1);
+            }
+        }
+    }
+    N = L->front;
+    p = 0;
+    if (L->length > SKIP_WALK) {
+        if (L->skip == NULL) {
+            buildSkip(L);
+        }
+        Tower T = L->skip;
+        for (int k = L->skip->height - 1; k >= 0; k--) {
+            while (T->link[k].next != NULL &&
+                   precedes(NODE_AT(L, T->link[k].next->node).data, x, strict, cmp, ctx)) {
+                p += T->link[k].width;
+                T = T->link[k].next;
+            }
+        }
+        if (T->node != NODE_NIL) {
+            N = NODE_AT(L, T->node).next;
+            p++;
+        }
+    }
+    while (N != NODE_NIL && precedes(NODE_AT(L, N).data, x, strict, cmp, ctx)) {
+        N = NODE_AT(L, N).next;
+        p++;
+        STAT_ADD(L, STAT_CURSOR_STEPS, 1);
+    }
+    *pN = N;
+    return p;
+}
+
+// Sharing functions ----------------------------------------------------------
+
+// copyList() shares the nodes of a List with the copy instead of copying
+// them. Every operation that changes the nodes of a List first calls
+// materialize(), which gives it a private copy if the chain is still shared.
+// A compact List is never shared; materialize() decodes it into nodes.
+// Either way materialize() bumps the version of the List, invalidating its
+// ListIters.
+
+// isShared()
+// Returns true (1) iff the nodes of L are shared with another List, dropping
+// the share record of L if every other holder has let go of them.
+int isShared(List L) {
+    if (L->share != NULL && soleRef(&L->share->refs)) {
+        free(L->share);
+        L->share = NULL;
+    }
+    return L->share != NULL;
+}
+
+// dropShare()
+// Lets go of the share record of L, freeing it if L was its last holder.
+void dropShare(List L) {
+    if (dropRef(&L->share->refs)) {
+        free(L->share);
+    }
+    L->share = NULL;
+}
+
+// materialize()
+// Gives L a private copy of its nodes, in a pool of its own, if it shares
+// them with another List, and ordinary nodes if it is compact. The cursor
+// stays on the same position; the positional index is dropped, unless the
+// node array of a LIST_INDEX build was copied whole.
+void materialize(List L) {
+    L->version++;
+    if (L->pack != NULL) {
+        Node first = NODE_NIL;
+        Node last = NODE_NIL;
+        if (L->length > 0) {
+            first = newNodes(L->pool, L->length, &last);
+            STAT_ADD(L, STAT_NODES_ALLOCATED, L->length);
+            STAT_ADD(L, STAT_BYTES_COPIED, L->length * sizeof(int));
+            Node M = first;
+            for (int i = 0; i < L->length; i++, M = NODE_AT(L, M).next) {
+                NODE_AT(L, M).data = packGet(L->pack, i);
+                if (i == L->cursor_index) {
+                    L->cursor = M;
+                }
+            }
+        }
+        freePack(&L->pack);
+        L->front = first;
+        L->back = last;
+        return;
+    }
+    if (!isShared(L)) {
+        return;
+    }
+#if defined(LIST_INDEX) && !defined(LIST_SHARED_POOL)
+    // an array mostly holding the nodes of L is copied in one go, and the
+    // positions, cursor and index with it; a sparser one is compacted below
+    if (L->pool->used <= 2 * (size_t)L->length + 1) {
+        Pool P = clonePool(L->pool);
+        STAT_ADD(L, STAT_NODES_ALLOCATED, L->length);
+        STAT_ADD(L, STAT_BYTES_COPIED, (size_t)P->used * sizeof(NodeObj));
+        releasePool(&L->pool);
+        L->pool = P;
+        dropShare(L);
+        return;
+    }
+#endif
+    Pool P = newPool();
+    Node first = NODE_NIL;
+    Node last = NODE_NIL;
+    Node cursor = NODE_NIL;
+    if (L->length > 0) {
+        first = newNodes(P, L->length, &last);
+        STAT_ADD(L, STAT_NODES_ALLOCATED, L->length);
+        STAT_ADD(L, STAT_BYTES_COPIED, L->length * sizeof(int));
+        Node M = first;
+        int i = 0;
+        for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next, M = POOL_AT(P, M).next, i++) {
+            POOL_AT(P, M).data = NODE_AT(L, N).data;
+            if (i == L->cursor_index) {
+                cursor = M;
+            }
+        }
+    }
+    releasePool(&L->pool);
+    L->pool = P;
+    dropShare(L);
+    L->front = first;
+    L->back = last;
+    L->cursor = cursor;
+    freeSkip(L);
+}
+
+// Hash functions -------------------------------------------------------------
+
+// The fingerprint of a List of the n elements e_0 ... e_(n-1) is the sum of
+// mixElement(e_i) * HASH_BASE^(n-1-i), mod 2^64. Appending multiplies it by
+// HASH_BASE before adding the new term, prepending adds the new term times
+// HASH_BASE^n, and deleting at either end undoes one or the other, which
+// HASH_BASE, being odd, allows. Any other change marks it stale by zeroing
+// hash_power, which no power of HASH_BASE is, and listHash() recomputes it.
+#define HASH_BASE 0x100000001b3ULL
+#define HASH_BASE_INVERSE 0xce965057aff6957bULL
+
+// mixElement()
+// Returns the term of x in a fingerprint, its 32 bits spread over all 64.
+unsigned long long mixElement(int x) {
+    unsigned long long z = (unsigned)x + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// hashAppend()
+// Updates the fingerprint of L for x appended after its back element.
+void hashAppend(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash = L->hash * HASH_BASE + mixElement(x);
+        L->hash_power *= HASH_BASE;
+    }
+}
+
+// hashPrepend()
+// Updates the fingerprint of L for x inserted before its front element.
+void hashPrepend(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash += mixElement(x) * L->hash_power;
+        L->hash_power *= HASH_BASE;
+    }
+}
+
+// hashDeleteFront()
+// Updates the fingerprint of L for its front element x deleted.
+void hashDeleteFront(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash_power *= HASH_BASE_INVERSE;
+        L->hash -= mixElement(x) * L->hash_power;
+    }
+}
+
+// hashDeleteBack()
+// Updates the fingerprint of L for its back element x deleted.
+void hashDeleteBack(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash = (L->hash - mixElement(x)) * HASH_BASE_INVERSE;
+        L->hash_power *= HASH_BASE_INVERSE;
+    }
+}
+
+// hashJoin()
+// Updates the fingerprint of L for the elements of S appended after its
+// back element. S may be L.
+void hashJoin(List L, List S) {
+    unsigned long long h = S->hash;
+    unsigned long long p = S->hash_power;
+    if (L->hash_power != 0 && p != 0) {
+        L->hash = L->hash * p + h;
+        L->hash_power *= p;
+    }
+    else {
+        L->hash_power = 0;
+    }
+}
+
+// Batch functions ------------------------------------------------------------
+
+// appendNodes()
+// Links the n nodes from first to last, already linked to each other, into
+// L after the back element.
+void appendNodes(List L, Node first, Node last, int n) {
+    int pos = L->length;
+    if (L->length == 0) {
+        L->front = first;
+    }
+    else {
+        NODE_AT(L, L->back).next = first;
+        NODE_AT(L, first).prev = L->back;
+    }
+    L->back = last;
+    L->length += n;
+    if (L->skip != NULL) {
+        for (Node N = first; N != NODE_NIL; N = NODE_AT(L, N).next) {
+            skipInsert(L, pos++, N);
+        }
+    }
+}
+
+// copyElements()
+// Copies the elements of S, in order, into the chain of nodes of L from
+// first, which is at least as long.
+void copyElements(List L, List S, Node first) {
+    (void)L;    // reaches the nodes of a LIST_INDEX build
+    Node M = first;
+    if (S->pack != NULL) {
+        for (int i = 0; i < S->length; i++, M = NODE_AT(L, M).next) {
+            NODE_AT(L, M).data = packGet(S->pack, i);
+        }
+        return;
+    }
+    for (Node N = S->front; N != NODE_NIL; N = NODE_AT(S, N).next, M = NODE_AT(L, M).next) {
+        NODE_AT(L, M).data = NODE_AT(S, N).data;
+    }
+}
+
+// appendCopy()
+// Appends a copy of every element of S to L in one batch. S may be L.
+void appendCopy(List L, List S) {
+    int n = S->length;
+    if (n == 0) {
+        return;
+    }
+    hashJoin(L, S);
+    Node last;
+    Node first = newNodes(L->pool, n, &last);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, n);
+    STAT_ADD(S, STAT_BYTES_COPIED, n * sizeof(int));
+    copyElements(L, S, first);
+    appendNodes(L, first, last, n);
+}
+
+// joinPools()
+// Leaves L and S drawing from one pool, so that nodes of S may be linked
+// into L. If S is the only user of its pool, its chunks move into the pool
+// of L; otherwise, if L is the only user of its own, L moves over to the
+// pool of S. Returns false (0), changing nothing, if both pools are shared
+// with other Lists. In a LIST_INDEX build an empty L moves to the pool of
+// S; else, if S is the only user of its pool, its array is appended to that
+// of L, which takes time in its size and moves the nodes of S to new
+// positions. The positional index of S is then stale; takeNodes() drops it.
+int joinPools(List L, List S) {
+    Pool P = L->pool;
+    Pool Q = S->pool;
+    if (P == Q) {
+        return 1;
+    }
+#ifdef LIST_INDEX
+    if (L->length == 0) {
+        releasePool(&L->pool);
+        L->pool = Q;
+        holdRef(&Q->refs);
+        return 1;
+    }
+    if (soleRef(&Q->refs)) {
+        uint32_t base = mergePool(P, Q);
+        S->front += base;
+        S->back += base;
+        if (S->cursor != NODE_NIL) {
+            S->cursor += base;
+        }
+        return 1;
+    }
+    return 0;
+#else
+    if (soleRef(&Q->refs)) {
+        mergePool(P, Q);
+        return 1;
+    }
+    if (soleRef(&P->refs)) {
+        mergePool(Q, P);
+        releasePool(&L->pool);
+        L->pool = Q;
+        holdRef(&Q->refs);
+        return 1;
+    }
+    return 0;
+#endif
+}
+
+// takeNodes()
+// Empties S, handing its nodes to L as a chain from *pFirst to *pLast, and
+// returns their number. The nodes are relinked, not copied, unless S shares
+// them with another List or the pools of L and S cannot be joined. A compact
+// S is decoded first. S must not be empty.
+int takeNodes(List L, List S, Node* pFirst, Node* pLast) {
+    int n = S->length;
+    if (S->pack != NULL) {
+        materialize(S);
+    }
+    if (!isShared(S) && joinPools(L, S)) {
+        *pFirst = S->front;
+        *pLast = S->back;
+        S->front = NODE_NIL;
+        S->back = NODE_NIL;
+        S->cursor = NODE_NIL;
+        S->length = 0;
+        S->cursor_index = -1;
+        S->version++;
+        S->hash = 0;
+        S->hash_power = 1;
+        freeSkip(S);
+        return n;
+    }
+    *pFirst = newNodes(L->pool, n, pLast);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, n);
+    STAT_ADD(S, STAT_BYTES_COPIED, n * sizeof(int));
+    copyElements(L, S, *pFirst);
+    clear(S);
+    return n;
+}
+
 // Access functions -----------------------------------------------------------
 
+#ifndef LIST_UNCHECKED
+
 // length()
 // Returns the number of elements in L.
 // Pre: List != NULL
 int length(List L) { 
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling length() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
+    FAIL_IF(L == NULL, "List Error: calling length() on NULL List reference\n");
     return L->length;
 }
 
@@ -96,11 +1147,8 @@ int length(List L) {
 // Returns index of cursor element if defined, -1 otherwise.
 // Pre: List != NULL
 int index(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling index() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
-    if ((L->cursor_index) < 0 || L->cursor == NULL) {
+    FAIL_IF(L == NULL, "List Error: calling index() on NULL List reference\n");
+    if ((L->cursor_index) < 0 || (L->cursor == NODE_NIL && L->pack == NULL)) {
         return -1;
     }
     else {
@@ -111,73 +1159,228 @@ int index(List L) {
 // front()
 // Returns front element of L. Pre: length()>0, List != NULL
 int front(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling front() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling front() on an empty List\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling front() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling front() on an empty List\n");
+    if (L->pack != NULL) {
+        return packGet(L->pack, 0);
     }
-    return L->front->data;
+    return NODE_AT(L, L->front).data;
 }
 
 // back()
 // Returns back element of L. Pre: length()>0, List != NULL
 int back(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling back() on NULL List reference\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling back() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling back() on an empty List\n");
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->length - 1);
     }
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling back() on an empty List\n");
-        exit(EXIT_FAILURE);
-    }
-    return L->back->data;
+    return NODE_AT(L, L->back).data;
 }
 
 // get()
 // Returns cursor element of L. Pre: length()>0, index()>=0
 // Pre: List!= NULL, length() > 0, index() >= 0 
 int get(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling get() on NULL List reference\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling get() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling get() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling get() on an undefined cursor element\n");
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->cursor_index);
     }
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling get() on an empty List\n");
-        exit(EXIT_FAILURE);
+    return NODE_AT(L, L->cursor).data;
+}
+
+#endif
+
+// getAt()
+// Returns the element at position i of L without moving the cursor.
+// Pre: List != NULL, 0 <= i < length()
+int getAt(List L, int i) {
+    FAIL_IF(L == NULL, "List Error: calling getAt() on NULL List reference\n");
+    FAIL_IF(i < 0 || i >= L->length, "List Error: calling getAt() with an index out of range\n");
+    STAT_TIME(LIST_OP_SEEK);
+    if (L->pack != NULL) {
+        return packGet(L->pack, i);
+    }
+    return NODE_AT(L, locate(L, i)).data;
+}
+
+// toArray()
+// Copies the first n elements of L into out, front first, or all of them if
+// L is shorter. Returns the number of elements copied.
+// Pre: List != NULL, out != NULL if n > 0
+int toArray(List L, int* out, size_t n) {
+    FAIL_IF(L == NULL, "List Error: calling toArray() on NULL List reference\n");
+    FAIL_IF(out == NULL && n > 0, "List Error: calling toArray() on NULL array\n");
+    STAT_TIME(LIST_OP_SCAN);
+    int k = (n < (size_t)L->length ? (int)n : L->length);
+    if (L->pack != NULL) {
+        packDecode(L->pack, out, k);
+        return k;
+    }
+    Node N = L->front;
+    for (int i = 0; i < k; i++) {
+        out[i] = NODE_AT(L, N).data;
+        N = NODE_AT(L, N).next;
+    }
+    return k;
+}
+
+// find()
+// Sets the cursor under the first element of L equal to x and returns its
+// index, or returns -1, leaving the cursor as it was, if there is none.
+// Pre: List != NULL
+int find(List L, int x) {
+    FAIL_IF(L == NULL, "List Error: calling find() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        int i = packFind(L->pack, x);
+        if (i >= 0) {
+            L->cursor_index = i;
+        }
+        return i;
+    }
+    int i = 0;
+    for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next, i++) {
+        if (NODE_AT(L, N).data == x) {
+            L->cursor = N;
+            L->cursor_index = i;
+            return i;
+        }
     }
-    if (!(index(L) >= 0)) {
-        fprintf(stderr, "List Error: calling get() on an undefined cursor element\n");
-        exit(EXIT_FAILURE);
+    return -1;
+}
+
+// count()
+// Returns the number of elements of L equal to x.
+// Pre: List != NULL
+int count(List L, int x) {
+    FAIL_IF(L == NULL, "List Error: calling count() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packCount(L->pack, x);
     }
-    return L->cursor->data;
+    int c = 0;
+    for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        c += (NODE_AT(L, N).data == x);
+    }
+    return c;
+}
+
+// sumList()
+// Returns the sum of the elements of L, 0 if it is empty.
+// Pre: List != NULL
+long long sumList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling sumList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packSum(L->pack);
+    }
+    long long s = 0;
+    for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        s += NODE_AT(L, N).data;
+    }
+    return s;
+}
+
+// minList()
+// Returns the least element of L.
+// Pre: List != NULL, length() > 0
+int minList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling minList() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling minList() on an empty List\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packMin(L->pack);
+    }
+    int m = NODE_AT(L, L->front).data;
+    for (Node N = NODE_AT(L, L->front).next; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        m = (NODE_AT(L, N).data < m ? NODE_AT(L, N).data : m);
+    }
+    return m;
+}
+
+// maxList()
+// Returns the greatest element of L.
+// Pre: List != NULL, length() > 0
+int maxList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling maxList() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling maxList() on an empty List\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packMax(L->pack);
+    }
+    int m = NODE_AT(L, L->front).data;
+    for (Node N = NODE_AT(L, L->front).next; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        m = (NODE_AT(L, N).data > m ? NODE_AT(L, N).data : m);
+    }
+    return m;
+}
+
+// listHash()
+// Returns the fingerprint of the elements of L, recomputing it first if it
+// is stale.
+// Pre: List != NULL
+unsigned long long listHash(List L) {
+    FAIL_IF(L == NULL, "List Error: calling listHash() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->hash_power != 0) {
+        return L->hash;
+    }
+    L->hash = 0;
+    L->hash_power = 1;
+    if (L->pack != NULL) {
+        for (int i = 0; i < L->length; i++) {
+            hashAppend(L, packGet(L->pack, i));
+        }
+        return L->hash;
+    }
+    for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        hashAppend(L, NODE_AT(L, N).data);
+    }
+    return L->hash;
 }
 
 // equals()
 // Returns true (1) iff Lists A and B are in same
-// state, and returns false (0) otherwise.
+// state, and returns false (0) otherwise. Lists whose
+// fingerprints differ are told apart in O(1) time.
 // Pre: List!= NULL
 int equals(List A, List B) {
     int eq = 0;
-    Node N = NULL;
-    Node M = NULL;
+    Node N = NODE_NIL;
+    Node M = NODE_NIL;
 
-    if (A == NULL || B == NULL)
-    {
-        fprintf(stderr, "List Error: calling equals() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
+    FAIL_IF(A == NULL || B == NULL, "List Error: calling equals() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
 
     eq = (A->length == B->length);
+    if (!eq || listHash(A) != listHash(B)) {
+        return 0;
+    }
+    if (A->pack != NULL && B->pack != NULL) {
+        return eq && packEquals(A->pack, B->pack);
+    }
+    if (A->pack != NULL || B->pack != NULL) {
+        Pack P = (A->pack != NULL ? A->pack : B->pack);
+        List L = (A->pack != NULL ? B : A);
+        N = L->front;
+        for (int i = 0; eq && N != NODE_NIL; i++, N = NODE_AT(L, N).next) {
+            eq = (packGet(P, i) == NODE_AT(L, N).data);
+        }
+        return eq;
+    }
+    if (eq && A->pool == B->pool && A->front == B->front) {
+        return eq;
+    }
     N = A->front;
     M = B->front;
-    while (eq && N != NULL)
+    while (eq && N != NODE_NIL)
     {
-        eq = (N->data == M->data);
-        N = N->next;
-        M = M->next;
+        eq = (NODE_AT(A, N).data == NODE_AT(B, M).data);
+        N = NODE_AT(A, N).next;
+        M = NODE_AT(B, M).next;
     }
     return eq;
 }
@@ -188,31 +1391,59 @@ int equals(List A, List B) {
 // Resets L to its original empty state.
 // Pre: List!= NULL
 void clear(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling clear() on NULL List reference\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling clear() on NULL List reference\n");
+    STAT_TIME(LIST_OP_DELETE);
+    L->version++;
+    L->hash = 0;
+    L->hash_power = 1;
+    if (L->pack != NULL) {
+        clearPack(L->pack);
+        L->length = 0;
+        L->cursor_index = -1;
+        return;
+    }
+    if (isShared(L)) {
+        // the nodes live on in the other Lists, so just let go of them
+        releasePool(&L->pool);
+        L->pool = newPool();
+        dropShare(L);
+        L->length = 0;
+        L->front = NODE_NIL;
+        L->back = NODE_NIL;
+        L->cursor = NODE_NIL;
+        L->cursor_index = -1;
     }
     if (!(L->length == 0)) {
-        while (L->length != 0) {
-            deleteFront(L);
-        };
-        L->front = NULL;
-        L->back = NULL;
-        L->cursor = NULL;
+        STAT_ADD(L, STAT_NODES_FREED, L->length);
+        if (soleRef(&L->pool->refs)) {
+            resetPool(L->pool);
+        }
+        else {
+            Node N = L->front;
+            while (N != NODE_NIL) {
+                Node M = NODE_AT(L, N).next;
+                freeNode(L->pool, &N);
+                N = M;
+            }
+        }
+        L->length = 0;
+        L->front = NODE_NIL;
+        L->back = NODE_NIL;
+        L->cursor = NODE_NIL;
         L->cursor_index = -1;
     }
+    freeSkip(L);
     return;
 }
 
+#ifndef LIST_UNCHECKED
+
 // moveFront()
 // If L is non-empty, sets cursor under the front element,
 // otherwise does nothing.
 // Pre: List!= NULL
 void moveFront(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling moveFront() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
+    FAIL_IF(L == NULL, "List Error: calling moveFront() on NULL List reference\n");
     if (L->length == 0) {
         return;
     }
@@ -226,10 +1457,7 @@ void moveFront(List L) {
 // otherwise does nothing.
 // Pre: List!= NULL
 void moveBack(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling moveBack() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
+    FAIL_IF(L == NULL, "List Error: calling moveBack() on NULL List reference\n");
     if (L->length == 0) {
         return;
     }
@@ -238,6 +1466,22 @@ void moveBack(List L) {
     return;
 }
 
+#endif
+
+// moveTo()
+// Sets cursor under the element at position i of L.
+// Pre: List != NULL, 0 <= i < length()
+void moveTo(List L, int i) {
+    FAIL_IF(L == NULL, "List Error: calling moveTo() on NULL List reference\n");
+    FAIL_IF(i < 0 || i >= L->length, "List Error: calling moveTo() with an index out of range\n");
+    STAT_TIME(LIST_OP_SEEK);
+    L->cursor = (L->pack != NULL ? NODE_NIL : locate(L, i));
+    L->cursor_index = i;
+    return;
+}
+
+#ifndef LIST_UNCHECKED
+
 // movePrev()
 // If cursor is defined and not at front, move cursor one
 // step toward the front of L; if cursor is defined and at
@@ -245,19 +1489,25 @@ void moveBack(List L) {
 // do nothing
 // Pre: List!= NULL
 void movePrev(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling movePrev() on NULL List reference\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling movePrev() on NULL List reference\n");
+    if (L->cursor_index >= 0) {
+        STAT_ADD(L, STAT_CURSOR_STEPS, 1);
+    }
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0) {
+            L->cursor_index--;
+        }
+        return;
     }
     if (L->cursor_index >= 0) {
         L->cursor_index--;
-        L->cursor = L->cursor->prev;
+        L->cursor = NODE_AT(L, L->cursor).prev;
     }
     else if (L->cursor_index == 0) {
         L->cursor_index = -1;
-        L->cursor = NULL;
+        L->cursor = NODE_NIL;
     }
-    else if (L->cursor_index < 0  || L->cursor == NULL) {
+    else if (L->cursor_index < 0  || L->cursor == NODE_NIL) {
         return;
     }
     return;
@@ -270,33 +1520,42 @@ void movePrev(List L) {
 // do nothing
 // Pre: List != NULL
 void moveNext(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling moveNext() on NULL List reference\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling moveNext() on NULL List reference\n");
+    if (L->cursor_index >= 0) {
+        STAT_ADD(L, STAT_CURSOR_STEPS, 1);
+    }
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0 && ++L->cursor_index == L->length) {
+            L->cursor_index = -1;
+        }
+        return;
     }
     if (L->cursor_index == (L->length - 1)) {
         L->cursor_index = -1;
-        L->cursor = NULL;
+        L->cursor = NODE_NIL;
     }
     else if (L->cursor_index >= 0 && L->cursor_index != (L->length-1)) {
         L->cursor_index++;
-        L->cursor = L->cursor->next;
+        L->cursor = NODE_AT(L, L->cursor).next;
     }
-    else if (L->cursor_index < 0 || L->cursor == NULL) {
+    else if (L->cursor_index < 0 || L->cursor == NODE_NIL) {
         return;
     }
     return;
 }
+#endif
+
 // prepend()
 // Insert new element into L. If L is non-empty,
 // insertion takes place before front element.
 // Pre: List!= NULL
 void prepend(List L, int data) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling prepend() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
-    Node M = newNode(data);
+    FAIL_IF(L == NULL, "List Error: calling prepend() on NULL List reference\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    hashPrepend(L, data);
+    Node M = newNode(L->pool, data);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
     if (L->length == 0) {
         L->length++;
         L->front = M;
@@ -306,11 +1565,14 @@ void prepend(List L, int data) {
             L->cursor_index++;
         }
         L->length++;
-        L->front->prev = M;
-        M->next = L->front;
-        M->prev = NULL;
+        NODE_AT(L, L->front).prev = M;
+        NODE_AT(L, M).next = L->front;
+        NODE_AT(L, M).prev = NODE_NIL;
         L->front = M;
     }
+    if (L->skip != NULL) {
+        skipInsert(L, 0, M);
+    }
     return;
 }
 
@@ -319,57 +1581,105 @@ void prepend(List L, int data) {
 // insertion takes place after back element.
 // Pre: List != NULL
 void append(List L, int data) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling append() on NULL List reference\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling append() on NULL List reference\n");
+    STAT_TIME(LIST_OP_INSERT);
+    hashAppend(L, data);
+    if (L->pack != NULL) {
+        packAppend(L->pack, data);
+        L->length++;
+        L->version++;
+        return;
     }
-    Node M = newNode(data);
+    materialize(L);
+    Node M = newNode(L->pool, data);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
     if (L->length == 0) {
         L->length++;
         L->front = M;
         L->back = M;
     } else {
-        L->back->next = M;
-        M->prev = L->back;
-        M->next = NULL;
+        NODE_AT(L, L->back).next = M;
+        NODE_AT(L, M).prev = L->back;
+        NODE_AT(L, M).next = NODE_NIL;
         L->back = M;
         L->length++;
     }
+    if (L->skip != NULL) {
+        skipInsert(L, L->length - 1, M);
+    }
+    return;
+}
+
+// appendArray()
+// Inserts the n elements of data into L, in order, after the back element.
+// The storage for them is taken in one batch.
+// Pre: List != NULL, data != NULL if n > 0, length() + n <= INT_MAX
+void appendArray(List L, const int* data, size_t n) {
+    FAIL_IF(L == NULL, "List Error: calling appendArray() on NULL List reference\n");
+    FAIL_IF(data == NULL && n > 0, "List Error: calling appendArray() on NULL array\n");
+    FAIL_IF(n > (size_t)(INT_MAX - L->length), "List Error: calling appendArray() with too many elements\n");
+    STAT_TIME(LIST_OP_INSERT);
+    for (size_t i = 0; i < n; i++) {
+        hashAppend(L, data[i]);
+    }
+    if (L->pack != NULL) {
+        for (size_t i = 0; i < n; i++) {
+            packAppend(L->pack, data[i]);
+        }
+        L->length += (int)n;
+        L->version++;
+        return;
+    }
+    materialize(L);
+    if (n == 0) {
+        return;
+    }
+    Node last;
+    Node first = newNodes(L->pool, (int)n, &last);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, n);
+    Node M = first;
+    for (size_t i = 0; i < n; i++, M = NODE_AT(L, M).next) {
+        NODE_AT(L, M).data = data[i];
+    }
+    appendNodes(L, first, last, (int)n);
     return;
 }
 
 // Insert new element before cursor.
 // Pre: length()>0, index()>=0, List != NULL
 void insertBefore(List L, int data) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling insertBefore() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    } 
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling insertBefore() on an empty List\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling insertBefore() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling insertBefore() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling insertBefore() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    if (L->cursor_index == 0) {
+        hashPrepend(L, data);
     }
-    if (!(index(L) >= 0)) {
-        fprintf(stderr, "List Error: calling insertBefore() on an undefined cursor element\n");
-        exit(EXIT_FAILURE);
+    else {
+        L->hash_power = 0;
     }
-    Node M = newNode(data);
+    Node M = newNode(L->pool, data);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
     if (L->length == 1 && L->cursor_index == 0) {
-        L->cursor->prev = M;
-        M->next = L->cursor;
+        NODE_AT(L, L->cursor).prev = M;
+        NODE_AT(L, M).next = L->cursor;
         L->front = M;
     }
     else if (L->cursor_index == 0) {
-        M->next = L->front;
-        L->front->prev = M;
+        NODE_AT(L, M).next = L->front;
+        NODE_AT(L, L->front).prev = M;
         L->front = M;
-        M->prev = NULL;
+        NODE_AT(L, M).prev = NODE_NIL;
     }
     else {
-        L->cursor->prev->next = M;
-        M->prev = L->cursor->prev;
-        L->cursor->prev = M;
-        M->next = L->cursor;
+        NODE_AT(L, NODE_AT(L, L->cursor).prev).next = M;
+        NODE_AT(L, M).prev = NODE_AT(L, L->cursor).prev;
+        NODE_AT(L, L->cursor).prev = M;
+        NODE_AT(L, M).next = L->cursor;
+    }
+    if (L->skip != NULL) {
+        skipInsert(L, L->cursor_index, M);
     }
     L->cursor_index++;
     L->length++;
@@ -380,35 +1690,38 @@ void insertBefore(List L, int data) {
 // Insert new element after cursor.
 // Pre: length()>0, index()>=0, List != NULL
 void insertAfter(List L, int data) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling insertAfter() on NULL List reference\n");
-        exit(EXIT_FAILURE);
+    FAIL_IF(L == NULL, "List Error: calling insertAfter() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling insertAfter() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling insertAfter() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    if (L->cursor_index == L->length - 1) {
+        hashAppend(L, data);
     }
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling insertAfter() on an empty List\n");
-        exit(EXIT_FAILURE);
-    }
-    if (!(index(L) >= 0)) {
-        fprintf(stderr, "List Error: calling insertAfter() on an undefined cursor element\n");
-        exit(EXIT_FAILURE);
+    else {
+        L->hash_power = 0;
     }
-    Node M = newNode(data);
+    Node M = newNode(L->pool, data);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
     if (L->length == 1 && L->cursor_index == 0) {
-        L->cursor->next = M;
-        M->prev = L->cursor;
+        NODE_AT(L, L->cursor).next = M;
+        NODE_AT(L, M).prev = L->cursor;
         L->back = M;
     }
     else if (L->cursor_index == (L->length - 1)) {
-        M->prev = L->back;
-        L->back->next = M;
+        NODE_AT(L, M).prev = L->back;
+        NODE_AT(L, L->back).next = M;
         L->back = M;
-        M->next = NULL;
+        NODE_AT(L, M).next = NODE_NIL;
     }
     else {
-        L->cursor->next->prev = M;
-        M->next = L->cursor->next;
-        M->prev = L->cursor;
-        L->cursor->next = M;
+        NODE_AT(L, NODE_AT(L, L->cursor).next).prev = M;
+        NODE_AT(L, M).next = NODE_AT(L, L->cursor).next;
+        NODE_AT(L, M).prev = L->cursor;
+        NODE_AT(L, L->cursor).next = M;
+    }
+    if (L->skip != NULL) {
+        skipInsert(L, L->cursor_index + 1, M);
     }
     L->length++;
     return;
@@ -416,59 +1729,61 @@ void insertAfter(List L, int data) {
 // deleteFront()
 // Delete the front element. Pre: length()>0, List != NULL
 void deleteFront(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling deleteFront() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling deleteFront() on an empty List\n");
-        exit(EXIT_FAILURE);
-    }
-    Node N = NULL;
+    FAIL_IF(L == NULL, "List Error: calling deleteFront() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling deleteFront() on an empty List\n");
+    STAT_TIME(LIST_OP_DELETE);
+    materialize(L);
+    Node N = NODE_NIL;
     N = L->front;
+    hashDeleteFront(L, NODE_AT(L, N).data);
+    if (L->skip != NULL) {
+        skipDelete(L, 0, N);
+    }
     if (L->length > 1) {
-        L->front = L->front->next;
-        L->front->prev = NULL;
+        L->front = NODE_AT(L, L->front).next;
+        NODE_AT(L, L->front).prev = NODE_NIL;
     }
     else {
-        L->front = L->back = NULL;
+        L->front = L->back = NODE_NIL;
     }
     if (L->cursor_index <= 0) {
-        L->cursor = NULL;
+        L->cursor = NODE_NIL;
         L->cursor_index = -1;
     }
     else {
         L->cursor_index--;
     }
-    freeNode(&N);
+    freeNode(L->pool, &N);
+    STAT_ADD(L, STAT_NODES_FREED, 1);
     L->length--;
     return;
 }
 // deleteBack()
 // Delete the back element. Pre: length()>0, List != NULL
 void deleteBack(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling deleteBack() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling deleteBack() on an empty List\n");
-        exit(EXIT_FAILURE);
-    }
-    Node N = NULL;
+    FAIL_IF(L == NULL, "List Error: calling deleteBack() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling deleteBack() on an empty List\n");
+    STAT_TIME(LIST_OP_DELETE);
+    materialize(L);
+    Node N = NODE_NIL;
     N = L->back;
+    hashDeleteBack(L, NODE_AT(L, N).data);
+    if (L->skip != NULL) {
+        skipDelete(L, L->length - 1, N);
+    }
     if (L->length > 1) {
-        L->back = L->back->prev;
-        L->back->next = NULL;
+        L->back = NODE_AT(L, L->back).prev;
+        NODE_AT(L, L->back).next = NODE_NIL;
     } 
     else {
-        L->front = L->back = NULL;
+        L->front = L->back = NODE_NIL;
     }
     if (L->cursor_index >= L->length - 1) {
-        L->cursor = NULL;
+        L->cursor = NODE_NIL;
         L->cursor_index = -1;
     }
-    freeNode(&N);
+    freeNode(L->pool, &N);
+    STAT_ADD(L, STAT_NODES_FREED, 1);
     L->length--;
     return;
 }
@@ -476,19 +1791,12 @@ void deleteBack(List L) {
 // Delete cursor element, making cursor undefined.
 // Pre: length()>0, index()>=0, List != NULL
 void delete(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling delete() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
-    if (L->length == 0) {
-        fprintf(stderr, "List Error: calling delete() on an empty List\n");
-        exit(EXIT_FAILURE);
-    }
-    if (!(index(L) >= 0)) {
-        fprintf(stderr, "List Error: calling delete() on an undefined cursor element\n");
-        exit(EXIT_FAILURE);
-    }
-    Node N = NULL;
+    FAIL_IF(L == NULL, "List Error: calling delete() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling delete() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling delete() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_DELETE);
+    materialize(L);
+    Node N = NODE_NIL;
     N = L->cursor;
     if (L->cursor_index == 0) {
         deleteFront(L);
@@ -497,60 +1805,358 @@ void delete(List L) {
         deleteBack(L);
     } 
     else {
-        N->next->prev = L->cursor->prev;
-        N->prev->next = L->cursor->next;
-        freeNode(&N);
+        L->hash_power = 0;
+        if (L->skip != NULL) {
+            skipDelete(L, L->cursor_index, N);
+        }
+        NODE_AT(L, NODE_AT(L, N).next).prev = NODE_AT(L, L->cursor).prev;
+        NODE_AT(L, NODE_AT(L, N).prev).next = NODE_AT(L, L->cursor).next;
+        freeNode(L->pool, &N);
+        STAT_ADD(L, STAT_NODES_FREED, 1);
         L->length--;
     }
+    L->cursor = NODE_NIL;
+    L->cursor_index = -1;
+    return;
+}
+
+// mergeRuns()
+// Merges the sorted chains A and B of nodes of L, linked through next and
+// ending in NODE_NIL, and returns the result. On ties elements of A come
+// first.
+Node mergeRuns(List L, Node A, Node B, int (*cmp)(int, int, void*), void* ctx) {
+    (void)L;    // reaches the nodes of a LIST_INDEX build
+#ifdef LIST_INDEX
+    // position 0 holds no node, so it can head the result
+    Node head = NODE_NIL;
+#else
+    NodeObj head_obj;
+    Node head = &head_obj;
+#endif
+    Node T = head;
+    while (A != NODE_NIL && B != NODE_NIL) {
+        if (cmp(NODE_AT(L, A).data, NODE_AT(L, B).data, ctx) <= 0) {
+            NODE_AT(L, T).next = A;
+            A = NODE_AT(L, A).next;
+        }
+        else {
+            NODE_AT(L, T).next = B;
+            B = NODE_AT(L, B).next;
+        }
+        T = NODE_AT(L, T).next;
+    }
+    NODE_AT(L, T).next = (A != NODE_NIL ? A : B);
+    return NODE_AT(L, head).next;
+}
+
+// sortList()
+// Sorts L into non-decreasing order under cmp, which returns a negative,
+// zero or positive value as its first argument is less than, equal to or
+// greater than its second; ctx is passed through to every call. The sort
+// is a stable natural merge sort that reuses the existing storage of L, so
+// already ordered runs cost one pass. The cursor becomes undefined.
+// Pre: List != NULL, cmp != NULL
+void sortList(List L, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling sortList() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling sortList() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_SORT);
+    materialize(L);
+    // pending[k] holds the merge of 2^k runs, like the digits of a binary
+    // counter; every run taken from L is added to it with carries.
+    Node pending[32] = { NODE_NIL };
+    Node N = L->front;
+    while (N != NODE_NIL) {
+        Node run = N;
+        Node last = N;
+        N = NODE_AT(L, N).next;
+        if (N != NODE_NIL && cmp(NODE_AT(L, last).data, NODE_AT(L, N).data, ctx) > 0) {
+            // strictly descending run: reverse it while taking it
+            NODE_AT(L, last).next = NODE_NIL;
+            while (N != NODE_NIL && cmp(NODE_AT(L, run).data, NODE_AT(L, N).data, ctx) > 0) {
+                Node M = NODE_AT(L, N).next;
+                NODE_AT(L, N).next = run;
+                run = N;
+                N = M;
+            }
+        }
+        else {
+            while (N != NODE_NIL && cmp(NODE_AT(L, last).data, NODE_AT(L, N).data, ctx) <= 0) {
+                last = N;
+                N = NODE_AT(L, N).next;
+            }
+            NODE_AT(L, last).next = NODE_NIL;
+        }
+        int k = 0;
+        while (pending[k] != NODE_NIL) {
+            run = mergeRuns(L, pending[k], run, cmp, ctx);
+            pending[k++] = NODE_NIL;
+        }
+        pending[k] = run;
+    }
+    Node sorted = NODE_NIL;
+    for (int k = 0; k < 32; k++) {
+        if (pending[k] != NODE_NIL) {
+            sorted = mergeRuns(L, pending[k], sorted, cmp, ctx);
+        }
+    }
+    L->front = sorted;
+    L->back = NODE_NIL;
+    L->hash_power = 0;
+    for (N = sorted; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        NODE_AT(L, N).prev = L->back;
+        L->back = N;
+    }
+    L->cursor = NODE_NIL;
     L->cursor_index = -1;
+    freeSkip(L);
     return;
 }
 
+// lowerBound()
+// Sets the cursor under the first element of L not less than x under cmp,
+// and returns its index, or makes the cursor undefined and returns length()
+// if every element is less. L must be sorted under cmp.
+// Pre: List != NULL, cmp != NULL
+int lowerBound(List L, int x, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling lowerBound() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling lowerBound() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_SEEK);
+    int p;
+    if (L->pack != NULL) {
+        p = packBound(L, x, 0, cmp, ctx);
+    }
+    else {
+        Node N;
+        p = seekBound(L, x, 0, cmp, ctx, &N);
+        L->cursor = N;
+    }
+    L->cursor_index = (p < L->length ? p : -1);
+    return p;
+}
+
+// findSorted()
+// Returns the index of the first element of L equal to x under cmp, with
+// the cursor under it, or -1 with the cursor as lowerBound() leaves it.
+// L must be sorted under cmp.
+// Pre: List != NULL, cmp != NULL
+int findSorted(List L, int x, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling findSorted() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling findSorted() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_SEEK);
+    int p = lowerBound(L, x, cmp, ctx);
+    if (p < L->length && cmp(get(L), x, ctx) == 0) {
+        return p;
+    }
+    return -1;
+}
+
+// insertSorted()
+// Inserts x into L after every element not greater than it under cmp, and
+// sets the cursor under it. L must be sorted under cmp.
+// Pre: List != NULL, cmp != NULL
+void insertSorted(List L, int x, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling insertSorted() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling insertSorted() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    Node N;
+    int p = seekBound(L, x, 1, cmp, ctx, &N);
+    if (p == L->length) {
+        append(L, x);
+        moveBack(L);
+        return;
+    }
+    L->cursor = N;
+    L->cursor_index = p;
+    insertBefore(L, x);
+    movePrev(L);
+    return;
+}
+
+// spliceList()
+// Moves every element of S to the back of L, in order, leaving S empty.
+// Nodes are relinked rather than copied, so this takes O(1) time unless
+// L has a positional index, which is dropped, or the pools of both Lists
+// are each shared with other Lists, in which case the elements are copied.
+// The cursor of L is unchanged.
+// Pre: L != NULL, S != NULL, L != S
+void spliceList(List L, List S) {
+    FAIL_IF(L == NULL || S == NULL, "List Error: calling spliceList() on NULL List reference\n");
+    FAIL_IF(L == S, "List Error: calling spliceList() on the same List twice\n");
+    STAT_TIME(LIST_OP_SPLICE);
+    if (S->length == 0) {
+        return;
+    }
+    materialize(L);
+    hashJoin(L, S);
+    Node first, last;
+    int n = takeNodes(L, S, &first, &last);
+    freeSkip(L);
+    appendNodes(L, first, last, n);
+    return;
+}
+
+// spliceAtCursor()
+// Moves every element of S into L, in order, directly before the cursor
+// element, leaving S empty. The cursor stays on the same element. Costs
+// as spliceList() does.
+// Pre: L != NULL, S != NULL, L != S, length()>0, index()>=0
+void spliceAtCursor(List L, List S) {
+    FAIL_IF(L == NULL || S == NULL, "List Error: calling spliceAtCursor() on NULL List reference\n");
+    FAIL_IF(L == S, "List Error: calling spliceAtCursor() on the same List twice\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling spliceAtCursor() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_SPLICE);
+    if (S->length == 0) {
+        return;
+    }
+    materialize(L);
+    Node first, last;
+    int n = takeNodes(L, S, &first, &last);
+    Node C = L->cursor;
+    freeSkip(L);
+    NODE_AT(L, first).prev = NODE_AT(L, C).prev;
+    if (NODE_AT(L, C).prev == NODE_NIL) {
+        L->front = first;
+    }
+    else {
+        NODE_AT(L, NODE_AT(L, C).prev).next = first;
+    }
+    NODE_AT(L, last).next = C;
+    NODE_AT(L, C).prev = last;
+    L->length += n;
+    L->cursor_index += n;
+    L->hash_power = 0;
+    return;
+}
+
+// splitAt()
+// Cuts L in two before the cursor element. Returns a new List holding the
+// cursor element and every element after it, and leaves the ones before it
+// in L. Both Lists share L's storage, and the cursor is undefined in both.
+// Takes O(1) time unless L has a positional index, which is dropped.
+// Pre: List != NULL, length()>0, index()>=0
+List splitAt(List L) {
+    FAIL_IF(L == NULL, "List Error: calling splitAt() on NULL List reference\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling splitAt() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_SPLICE);
+    materialize(L);
+    List R = newList();
+    releasePool(&R->pool);
+    R->pool = L->pool;
+    holdRef(&R->pool->refs);
+    Node N = L->cursor;
+    R->front = N;
+    R->back = L->back;
+    R->length = L->length - L->cursor_index;
+    L->back = NODE_AT(L, N).prev;
+    if (L->back == NODE_NIL) {
+        L->front = NODE_NIL;
+    }
+    else {
+        NODE_AT(L, L->back).next = NODE_NIL;
+    }
+    NODE_AT(L, N).prev = NODE_NIL;
+    L->length = L->cursor_index;
+    L->cursor = NODE_NIL;
+    L->cursor_index = -1;
+    L->hash_power = 0;
+    R->hash_power = 0;
+    freeSkip(L);
+    return R;
+}
+
 // Other operations -----------------------------------------------------------
 
+// Lists of at most PRINT_BATCH elements are printed with one fwrite() of
+// a stack buffer, as a Writer would cost more than it saves; longer ones
+// go through a Writer, PRINT_BATCH elements at a time.
+#define PRINT_BATCH 64
+
 // printList()
 // Prints to the file pointed to by out, a
 // string representation of L consisting
 // of a space separated sequence of integers,
-// with front on left.
+// with front on left. Returns 0, or -1 with errno
+// set if writing fails.
 // Pre: file != NULL, List != NULL
-void printList(FILE* out, List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling printList() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
-    if (out == NULL) {
-        fprintf(stderr, "File Error: calling printList() on NULL file pointer");
-        exit(EXIT_FAILURE);
-    }
-    Node N = NULL;
-    N = L->front;
-    while (N != NULL) {
-        fprintf(out, "%d ", N->data);
-        N = N->next;
+int printList(FILE* out, List L) {
+    FAIL_IF(L == NULL, "List Error: calling printList() on NULL List reference\n");
+    FAIL_IF(out == NULL, "File Error: calling printList() on NULL file pointer");
+    STAT_TIME(LIST_OP_IO);
+    int data[PRINT_BATCH];
+    if (L->length <= PRINT_BATCH) {
+        char text[PRINT_BATCH * WRITER_INT_CHARS];
+        toArray(L, data, L->length);
+        size_t n = formatInts(text, data, L->length);
+        return (fwrite(text, 1, n, out) == n ? 0 : -1);
+    }
+    Writer W = newWriter(out);
+    if (L->pack != NULL) {
+        printPack(W, L->pack);
+    }
+    int k = 0;
+    for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        data[k++] = NODE_AT(L, N).data;
+        if (k == PRINT_BATCH) {
+            writeInts(W, data, k);
+            k = 0;
+        }
     }
-    return;
+    writeInts(W, data, k);
+    return freeWriter(&W);
+}
+
+// saveList()
+// Writes L to out in binary, to be read back by loadList() or mapList().
+// Returns 0, or -1 with errno set if writing fails.
+// Pre: List != NULL, out != NULL
+int saveList(List L, FILE* out) {
+    FAIL_IF(L == NULL, "List Error: calling saveList() on NULL List reference\n");
+    FAIL_IF(out == NULL, "File Error: calling saveList() on NULL file pointer\n");
+    STAT_TIME(LIST_OP_IO);
+    int* data = malloc((L->length > 0 ? L->length : 1) * sizeof(int));
+    toArray(L, data, L->length);
+    int result = writeListFile(out, data, L->length);
+    free(data);
+    return result;
 }
 
 // copyList()
 // Returns a new List representing the same integer
 // sequence as L. The cursor in the new list is undefined,
 // regardless of the state of the cursor in L. The state
-// of L is unchanged.
+// of L is unchanged. Takes O(1) time: the copy shares
+// the nodes of L until either List is changed. The copy
+// of a compact List is compact, and copies its blocks.
 // Pre: List!= NULL
 List copyList(List L) {
-    if (L == NULL) {
-        fprintf(stderr, "List Error: calling copyList() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
+    FAIL_IF(L == NULL, "List Error: calling copyList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_COPY);
     List Y = newList();
-    Node N = NULL;
-    N = L->front;
-    Y->cursor_index = -1;
-    while (N != NULL) {
-        append(Y, N->data);
-        N = N->next;
+    Y->hash = L->hash;
+    Y->hash_power = L->hash_power;
+    STAT_ADD(L, STAT_COPIES, 1);
+    if (L->pack != NULL) {
+        Y->pack = copyPack(L->pack);
+        STAT_ADD(L, STAT_BYTES_COPIED, packBytes(Y->pack));
+        Y->length = L->length;
+        return Y;
     }
+    if (L->length == 0) {
+        return Y;
+    }
+    if (L->share == NULL) {
+        L->share = malloc(sizeof(ShareObj));
+        L->share->refs = 1;
+    }
+    holdRef(&L->share->refs);
+    Y->share = L->share;
+    releasePool(&Y->pool);
+    Y->pool = L->pool;
+    holdRef(&Y->pool->refs);
+    Y->front = L->front;
+    Y->back = L->back;
+    Y->length = L->length;
     return Y;
 }
 
@@ -560,23 +2166,240 @@ List copyList(List L) {
 // regardless of the states of the cursors in A and B.
 // The states of A and B are unchanged.
 List concatList(List A, List B) {
-    if (A == NULL || B == NULL) {
-        fprintf(stderr, "List Error: calling copyList() on NULL List reference\n");
-        exit(EXIT_FAILURE);
-    }
+    FAIL_IF(A == NULL || B == NULL, "List Error: calling copyList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_COPY);
     List Y = newList();
-    Node temp = A->front;
-    while (temp != NULL) {
-        append(Y, temp->data);
-        temp = temp->next;
+    STAT_ADD(A, STAT_CONCATS, 1);
+    STAT_ADD(B, STAT_CONCATS, 1);
+    appendCopy(Y, A);
+    appendCopy(Y, B);
+    return Y;
+}
+
+// packList()
+// Switches L to compact mode, see newPackedList(), keeping its elements and
+// cursor position.
+// Pre: List != NULL
+void packList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling packList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_COPY);
+    if (L->pack != NULL) {
+        return;
     }
-    temp = B->front;
-    while (temp != NULL) {
-        append(Y, temp->data);
-        temp = temp->next;
+    Pack P = newPack();
+    for (Node N = L->front; N != NODE_NIL; N = NODE_AT(L, N).next) {
+        packAppend(P, NODE_AT(L, N).data);
+    }
+    STAT_ADD(L, STAT_BYTES_COPIED, L->length * sizeof(int));
+    int n = L->length;
+    int i = index(L);
+    unsigned long long h = L->hash;
+    unsigned long long p = L->hash_power;
+    clear(L);
+    L->pack = P;
+    L->length = n;
+    L->cursor_index = i;
+    L->hash = h;
+    L->hash_power = p;
+    return;
+}
+
+// listBytes()
+// Returns the number of bytes of heap memory holding L and its elements.
+// Storage shared with copies is counted in full.
+// Pre: List != NULL
+size_t listBytes(List L) {
+    FAIL_IF(L == NULL, "List Error: calling listBytes() on NULL List reference\n");
+    if (L->pack != NULL) {
+        return sizeof(ListObj) + sizeof(LockObj) + STAT_BYTES + packBytes(L->pack);
     }
-    return Y;
+    return sizeof(ListObj) + sizeof(LockObj) + STAT_BYTES + (size_t)L->length * sizeof(NodeObj);
+}
+
+// Iterators ------------------------------------------------------------------
+
+// newListIter()
+// Returns reference to new ListIter over L, with its position undefined.
+// Pre: List != NULL
+ListIter newListIter(List L) {
+    FAIL_IF(L == NULL, "List Error: calling newListIter() on NULL List reference\n");
+    ListIter I = malloc(sizeof(ListIterObj));
+    I->list = L;
+    I->node = NODE_NIL;
+    I->index = -1;
+    I->version = L->version;
+    I->decoded = -1;
+    I->buffer = NULL;
+    return(I);
+}
+
+// freeListIter()
+// Frees all heap memory associated with ListIter *pI, and sets *pI to NULL.
+// Pre: ListIter != NULL
+void freeListIter(ListIter* pI) {
+    FAIL_IF(pI == NULL || *pI == NULL, "List Error: calling freeListIter() on NULL ListIter reference\n");
+    free((*pI)->buffer);
+    free(*pI);
+    *pI = NULL;
+}
+
+// iterFront()
+// Begins a new traversal of the List of I: if it is non-empty, sets I on
+// its front element, otherwise makes the position of I undefined.
+// Pre: ListIter != NULL
+void iterFront(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterFront() on NULL ListIter reference\n");
+    List L = I->list;
+    I->version = L->version;
+    I->index = (L->length > 0 ? 0 : -1);
+    I->node = L->front;
+}
+
+// iterBack()
+// Begins a new traversal of the List of I: if it is non-empty, sets I on
+// its back element, otherwise makes the position of I undefined.
+// Pre: ListIter != NULL
+void iterBack(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterBack() on NULL ListIter reference\n");
+    List L = I->list;
+    I->version = L->version;
+    I->index = L->length - 1;
+    I->node = L->back;
+}
+
+// iterIndex()
+// Returns index of the element under I if defined, -1 otherwise.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+int iterIndex(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterIndex() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterIndex() on ListIter invalidated by a change to its List\n");
+    return I->index;
+}
+
+// iterGet()
+// Returns the element under I. The blocks of a compact List are decoded
+// into I, one at a time, so that the List itself is only read.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began,
+// iterIndex() >= 0
+int iterGet(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterGet() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterGet() on ListIter invalidated by a change to its List\n");
+    FAIL_IF(I->index < 0, "List Error: calling iterGet() on an undefined ListIter position\n");
+    if (I->list->pack != NULL) {
+        int b = I->index / PACK_BLOCK;
+        if (b != I->decoded) {
+            if (I->buffer == NULL) {
+                I->buffer = malloc(PACK_BLOCK * sizeof(int));
+            }
+            packBlock(I->list->pack, b, I->buffer);
+            I->decoded = b;
+        }
+        return I->buffer[I->index % PACK_BLOCK];
+    }
+    return NODE_AT(I->list, I->node).data;
+}
+
+// iterPrev()
+// Moves I one step toward the front, as movePrev() moves the cursor.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+void iterPrev(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterPrev() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterPrev() on ListIter invalidated by a change to its List\n");
+    if (I->index < 0) {
+        return;
+    }
+    I->index--;
+    if (I->list->pack == NULL) {
+        I->node = NODE_AT(I->list, I->node).prev;
+    }
+}
+
+// iterNext()
+// Moves I one step toward the back, as moveNext() moves the cursor.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+void iterNext(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterNext() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterNext() on ListIter invalidated by a change to its List\n");
+    if (I->index < 0) {
+        return;
+    }
+    if (++I->index == I->list->length) {
+        I->index = -1;
+    }
+    if (I->list->pack == NULL) {
+        I->node = NODE_AT(I->list, I->node).next;
+    }
+}
+
+// Locking --------------------------------------------------------------------
+
+// readLockList()
+// Waits until no thread holds or awaits the write lock of L, then takes a
+// read lock.
+// Pre: List != NULL
+void readLockList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling readLockList() on NULL List reference\n");
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_lock(&K->mutex);
+    while (K->writers > 0) {
+        pthread_cond_wait(&K->readable, &K->mutex);
+    }
+    K->readers++;
+    pthread_mutex_unlock(&K->mutex);
+}
+
+// writeLockList()
+// Waits until no thread holds any lock of L, then takes the write lock.
+// Pre: List != NULL
+void writeLockList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling writeLockList() on NULL List reference\n");
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_lock(&K->mutex);
+    K->writers++;
+    while (K->readers > 0 || K->writing) {
+        pthread_cond_wait(&K->writable, &K->mutex);
+    }
+    K->writing = 1;
+    pthread_mutex_unlock(&K->mutex);
 }
 
+// unlockList()
+// Releases the read or write lock of L held by this thread, waking the
+// next writer if there is one, else every waiting reader.
+// Pre: List != NULL, lock of L held by this thread
+void unlockList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling unlockList() on NULL List reference\n");
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_lock(&K->mutex);
+    if (K->writing) {
+        K->writing = 0;
+        K->writers--;
+    }
+    else {
+        K->readers--;
+    }
+    if (K->writers > 0) {
+        if (K->readers == 0) {
+            pthread_cond_signal(&K->writable);
+        }
+    }
+    else {
+        pthread_cond_broadcast(&K->readable);
+    }
+    pthread_mutex_unlock(&K->mutex);
+}
 
+// Statistics -----------------------------------------------------------------
+
+#ifdef LIST_STATS
+
+// listStats()
+// Fills *out with the counters of L, or with the totals of every List if L
+// is NULL.
+// Pre: out != NULL
+void listStats(List L, ListStats* out) {
+    FAIL_IF(out == NULL, "List Error: calling listStats() on NULL ListStats reference\n");
+    statRead(L != NULL ? LIST_COUNTS(L) : NULL, out);
+}
 
+#endif
@@ -6,6 +6,11 @@
  // Exported type --------------------------------------------------------------
 typedef struct ListObj* List;
 
+// A ListIter walks a List like the cursor does, but lives outside it, so
+// that any number of them, on any number of threads, can traverse one List
+// without changing it. See the Iterators section below.
+typedef struct ListIterObj* ListIter;
+
 
 // Constructors-Destructors ---------------------------------------------------
 
@@ -13,6 +18,42 @@ typedef struct ListObj* List;
 // Returns reference to new empty List object.
 List newList(void);
 
+// newListFromArray()
+// Returns reference to new List object holding the n elements of data,
+// in order. The cursor is undefined.
+// Pre: data != NULL if n > 0
+List newListFromArray(const int* data, size_t n);
+
+// newPackedList()
+// Returns reference to new empty List object in compact mode. A compact
+// List stores its elements in blocks of 128, each element after the first
+// of a block as the varint of its difference from the one before, so a run
+// of close or increasing values costs a byte or two per element instead of
+// a node. A block is decoded when the cursor or getAt() enters it. Access
+// functions, cursor moves, append(), appendArray(), clear(), printList(),
+// equals() and copyList() work on the encoded blocks; any other change
+// first turns L back into an ordinary List.
+List newPackedList(void);
+
+// loadList()
+// Returns reference to new List object holding the elements that
+// saveList() wrote to in, which is read up to their end. Returns NULL, with
+// errno set, if reading fails, or EINVAL if in holds no saved List or its
+// checksum does not match.
+// Pre: in != NULL
+List loadList(FILE* in);
+
+// mapList()
+// Returns reference to new List object over the elements that saveList()
+// wrote to the file named path, read in place from a read-only mapping, so
+// that it takes the same time for any length. Only the header is checked,
+// not the checksum. Access functions and cursor moves read the file; the
+// first change copies the elements into memory, as for a compact List,
+// and the file is never written. Returns NULL, with errno set, if the file
+// cannot be mapped, or EINVAL if it holds no saved List.
+// Pre: path != NULL
+List mapList(const char* path);
+
 // freeList()
 // Frees all heap memory associated with List *pL, and sets *pL to NULL.
 // Pre: List != NULL
@@ -20,6 +61,8 @@ void freeList(List* pL);
 
 // Access functions -----------------------------------------------------------
 
+#ifndef LIST_UNCHECKED
+
 // length()
 // Returns the number of elements in L.
 // Pre: List != NULL
@@ -43,9 +86,63 @@ int back(List L);
 // Pre: List!= NULL, length() > 0, index() >= 0 
 int get(List L); 
 
+#endif
+
+// getAt()
+// Returns the element at position i of L without moving the cursor.
+// Runs in O(log n) once L has been indexed, see moveTo().
+// Pre: List != NULL, 0 <= i < length()
+int getAt(List L, int i);
+
+// toArray()
+// Copies the first n elements of L into out, front first, or all of them if
+// L is shorter. Returns the number of elements copied.
+// Pre: List != NULL, out != NULL if n > 0
+int toArray(List L, int* out, size_t n);
+
+// find()
+// Sets the cursor under the first element of L equal to x and returns its
+// index, or returns -1, leaving the cursor as it was, if there is none.
+// Runs of contiguous elements, the blocks of ListBlock.c and of a compact
+// or mapped List, are searched with AVX2 or SSE4.1 where the CPU has them.
+// Pre: List != NULL
+int find(List L, int x);
+
+// count()
+// Returns the number of elements of L equal to x. Vectorized as find() is.
+// Pre: List != NULL
+int count(List L, int x);
+
+// sumList()
+// Returns the sum of the elements of L, 0 if it is empty. Vectorized as
+// find() is.
+// Pre: List != NULL
+long long sumList(List L);
+
+// minList()
+// Returns the least element of L. Vectorized as find() is.
+// Pre: List != NULL, length() > 0
+int minList(List L);
+
+// maxList()
+// Returns the greatest element of L. Vectorized as find() is.
+// Pre: List != NULL, length() > 0
+int maxList(List L);
+
+// listHash()
+// Returns a 64 bit fingerprint of the elements of L, in order: equal Lists
+// have equal fingerprints, and unequal ones almost never do. Appends,
+// prepends, deletions at either end, spliceList() and concatList() keep it
+// up to date in O(1) time per element; any other change leaves it stale,
+// and the next call recomputes it in one pass.
+// Pre: List != NULL
+unsigned long long listHash(List L);
+
 // equals()
 // Returns true (1) iff Lists A and B are in same
-// state, and returns false (0) otherwise.
+// state, and returns false (0) otherwise. Compares
+// the fingerprints of listHash() first, so unequal
+// Lists are usually told apart in O(1) time.
 // Pre: List!= NULL
 int equals(List A, List B); 
 
@@ -56,6 +153,8 @@ int equals(List A, List B);
 // Pre: List!= NULL
 void clear(List L); 
 
+#ifndef LIST_UNCHECKED
+
 // moveFront()
 // If L is non-empty, sets cursor under the front element,
 // otherwise does nothing.
@@ -68,6 +167,17 @@ void moveFront(List L);
 // Pre: List!= NULL
 void moveBack(List L); 
 
+#endif
+
+// moveTo()
+// Sets cursor under the element at position i of L. Far seeks build a
+// positional index on first use, after which seeks and every insertion
+// and deletion cost O(log n) until L is cleared.
+// Pre: List != NULL, 0 <= i < length()
+void moveTo(List L, int i);
+
+#ifndef LIST_UNCHECKED
+
 // movePrev()
 // If cursor is defined and not at front, move cursor one
 // step toward the front of L; if cursor is defined and at
@@ -84,6 +194,8 @@ void movePrev(List L);
 // Pre: List != NULL
 void moveNext(List L); 
 
+#endif
+
 // prepend()
 // Insert new element into L. If L is non-empty,
 // insertion takes place before front element.
@@ -96,6 +208,12 @@ void prepend(List L, int data);
 // Pre: List != NULL
 void append(List L, int data); 
 
+// appendArray()
+// Inserts the n elements of data into L, in order, after the back element.
+// The storage for them is taken in one batch.
+// Pre: List != NULL, data != NULL if n > 0, length() + n <= INT_MAX
+void appendArray(List L, const int* data, size_t n);
+
 // Insert new element before cursor.
 // Pre: length()>0, index()>=0, List != NULL
 void insertBefore(List L, int data); 
@@ -118,21 +236,109 @@ void deleteBack(List L); // Delete the back element. Pre: length()>0
 // Pre: length()>0, index()>=0, List != NULL
 void delete(List L); 
 
+// sortList()
+// Sorts L into non-decreasing order under cmp, which returns a negative,
+// zero or positive value as its first argument is less than, equal to or
+// greater than its second; ctx is passed through to every call. The sort
+// is a stable natural merge sort that reuses the existing storage of L, so
+// already ordered runs cost one pass. The cursor becomes undefined.
+// Pre: List != NULL, cmp != NULL
+void sortList(List L, int (*cmp)(int, int, void*), void* ctx);
+
+// lowerBound()
+// Sets the cursor under the first element of L that is not less than x
+// under cmp, and returns its index. If every element is less than x, the
+// cursor becomes undefined and length() is returned. L must be sorted
+// under cmp, as sortList() leaves it; ctx is passed through to cmp. The
+// search starts from the cursor as a finger: a bound within a few dozen
+// elements of it is walked to, and a farther one is found by searching
+// the positional index of moveTo() by value, in O(log n). A compact List
+// is binary searched instead.
+// Pre: List != NULL, cmp != NULL
+int lowerBound(List L, int x, int (*cmp)(int, int, void*), void* ctx);
+
+// findSorted()
+// Returns the index of the first element of L equal to x under cmp and
+// sets the cursor under it, or returns -1, leaving the cursor where
+// lowerBound() does. L must be sorted under cmp.
+// Pre: List != NULL, cmp != NULL
+int findSorted(List L, int x, int (*cmp)(int, int, void*), void* ctx);
+
+// insertSorted()
+// Inserts x into L after every element not greater than it under cmp,
+// so that L stays sorted and equal elements keep their insertion order,
+// and sets the cursor under it. The position is found as lowerBound()
+// finds its own, so a run of insertions of nearby values costs O(1) each.
+// Pre: List != NULL, cmp != NULL
+void insertSorted(List L, int x, int (*cmp)(int, int, void*), void* ctx);
+
+// spliceList()
+// Moves every element of S to the back of L, in order, leaving S empty.
+// Nodes are relinked rather than copied, so this takes O(1) time unless
+// L has a positional index, which is dropped, or the pools of both Lists
+// are each shared with other Lists, in which case the elements are copied.
+// A LIST_INDEX build keeps the nodes of every pool in one array, which
+// cannot be linked to another in O(1) time: unless L is empty or both Lists
+// already draw from one pool, the array of S is appended to that of L, in
+// time linear in its size, or, if other Lists draw from it, the elements of
+// S are copied. The cursor of L is unchanged.
+// Pre: L != NULL, S != NULL, L != S
+void spliceList(List L, List S);
+
+// spliceAtCursor()
+// Moves every element of S into L, in order, directly before the cursor
+// element, leaving S empty. The cursor stays on the same element. Costs
+// as spliceList() does; as L is not empty, in a LIST_INDEX build that is
+// time linear in the node array of S unless both Lists already draw from
+// one pool.
+// Pre: L != NULL, S != NULL, L != S, length()>0, index()>=0
+void spliceAtCursor(List L, List S);
+
+// splitAt()
+// Cuts L in two before the cursor element. Returns a new List holding the
+// cursor element and every element after it, and leaves the ones before it
+// in L. Both Lists share L's storage, and the cursor is undefined in both.
+// Takes O(1) time unless L has a positional index, which is dropped.
+// Pre: List != NULL, length()>0, index()>=0
+List splitAt(List L);
+
 // Other operations -----------------------------------------------------------
 
 // printList()
 // Prints to the file pointed to by out, a
 // string representation of L consisting
 // of a space separated sequence of integers,
-// with front on left.
+// with front on left. A List of up to 64 elements
+// is formatted on the stack and handed to out with
+// one fwrite(). For a longer one, anything buffered
+// in out is flushed first; the integers are then
+// formatted into a large buffer of their own and
+// written to the file descriptor of out in few
+// writev() calls. Returns 0, or -1 with errno set if
+// writing fails. The writev() calls bypass the stdio
+// buffer of out, so their failure does not show in
+// ferror() or fclose() of out; only this return
+// value reports it.
 // Pre: file != NULL, List != NULL
-void printList(FILE* out, List L); 
+int printList(FILE* out, List L); 
+
+// saveList()
+// Writes L to out in binary, as a 32 byte header (magic, format version,
+// byte order mark, int width, length and a checksum of the elements)
+// followed by the elements as native ints, front first. The file can be
+// read back by loadList() or mapped by mapList() on a machine of the same
+// byte order and int width. Returns 0, or -1 with errno set if writing
+// fails. The state of L is unchanged.
+// Pre: List != NULL, out != NULL
+int saveList(List L, FILE* out);
 
 // copyList()
 // Returns a new List representing the same integer
 // sequence as L. The cursor in the new list is undefined,
 // regardless of the state of the cursor in L. The state
-// of L is unchanged.
+// of L is unchanged. Takes O(1) time: the copy shares
+// the storage of L until either List is changed. The
+// copy of a compact List is compact, and copies its blocks.
 // Pre: List!= NULL								
 List copyList(List L); 
 
@@ -143,3 +349,169 @@ List copyList(List L);
 // The states of A and B are unchanged.
 List concatList(List A, List B); 
 
+// packList()
+// Switches L to compact mode, see newPackedList(), keeping its elements and
+// cursor position.
+// Pre: List != NULL
+void packList(List L);
+
+// listBytes()
+// Returns the number of bytes of heap memory holding L and its elements.
+// Storage shared with copies is counted in full.
+// Pre: List != NULL
+size_t listBytes(List L);
+
+// Iterators ------------------------------------------------------------------
+
+// A ListIter records the version of its List when its traversal begins.
+// Every change to the List, anything but a cursor move, bumps the version,
+// after which the ListIter functions other than iterFront(), iterBack() and
+// freeListIter() report the ListIter invalid, as a precondition failure.
+// ListIters only read their List, and a compact one is decoded into the
+// ListIter, never into the List itself.
+
+// newListIter()
+// Returns reference to new ListIter over L, with its position undefined.
+// Pre: List != NULL
+ListIter newListIter(List L);
+
+// freeListIter()
+// Frees all heap memory associated with ListIter *pI, and sets *pI to NULL.
+// Pre: ListIter != NULL
+void freeListIter(ListIter* pI);
+
+// iterFront()
+// Begins a new traversal of the List of I: if it is non-empty, sets I on
+// its front element, otherwise makes the position of I undefined.
+// Pre: ListIter != NULL
+void iterFront(ListIter I);
+
+// iterBack()
+// Begins a new traversal of the List of I: if it is non-empty, sets I on
+// its back element, otherwise makes the position of I undefined.
+// Pre: ListIter != NULL
+void iterBack(ListIter I);
+
+// iterIndex()
+// Returns index of the element under I if defined, -1 otherwise.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+int iterIndex(ListIter I);
+
+// iterGet()
+// Returns the element under I.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began,
+// iterIndex() >= 0
+int iterGet(ListIter I);
+
+// iterPrev()
+// Moves I one step toward the front, as movePrev() moves the cursor.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+void iterPrev(ListIter I);
+
+// iterNext()
+// Moves I one step toward the back, as moveNext() moves the cursor.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+void iterNext(ListIter I);
+
+// Locking --------------------------------------------------------------------
+
+// Each List carries a reader-writer lock, which the List functions never
+// take themselves. Threads sharing a List take a read lock to traverse it
+// with ListIters, reading only length() and the ListIter functions, and the
+// write lock for anything else, cursor moves and copyList() included, as
+// those change the List behind the scenes. A List and the snapshots that
+// copyList() takes of it may each be handed to another thread, under a lock
+// of its own: the storage they share is counted atomically, and whichever
+// changes first copies it.
+
+// readLockList()
+// Waits until no thread holds or awaits the write lock of L, then takes a
+// read lock. Waiting writers go first, so readers cannot starve them.
+// Pre: List != NULL
+void readLockList(List L);
+
+// writeLockList()
+// Waits until no thread holds any lock of L, then takes the write lock.
+// Pre: List != NULL
+void writeLockList(List L);
+
+// unlockList()
+// Releases the read or write lock of L held by this thread.
+// Pre: List != NULL, lock of L held by this thread
+void unlockList(List L);
+
+// Statistics -----------------------------------------------------------------
+
+#ifdef LIST_STATS
+
+// Built with LIST_STATS, List.c (or ListBlock.c) and ListStats.c count the
+// work every List does, and time one call in LIST_STATS_SAMPLE of every
+// kind of operation below; clients see these declarations when built with
+// it too. Without it the counting is compiled out and none of this exists.
+// Nodes are the blocks of ListBlock.c there. Cursor moves inlined into a
+// LIST_UNCHECKED client are not counted.
+
+// Kinds of operation timed by the latency histograms.
+typedef enum ListOp {
+    LIST_OP_INSERT, // prepend(), append(), appendArray(), insertBefore(),
+                    // insertAfter(), insertSorted()
+    LIST_OP_DELETE, // deleteFront(), deleteBack(), delete(), clear(), freeList()
+    LIST_OP_SEEK,   // moveTo(), getAt(), lowerBound(), findSorted()
+    LIST_OP_SCAN,   // toArray(), find(), count(), sumList(), minList(),
+                    // maxList(), listHash(), equals()
+    LIST_OP_SORT,   // sortList()
+    LIST_OP_COPY,   // copyList(), concatList(), packList()
+    LIST_OP_SPLICE, // spliceList(), spliceAtCursor(), splitAt()
+    LIST_OP_IO,     // loadList(), mapList(), printList(), saveList()
+    LIST_OPS
+} ListOp;
+
+// Buckets of a latency histogram: bucket b counts the sampled calls that
+// took from 2^b up to 2^(b+1) nanoseconds, the first also any quicker ones
+// and the last any slower ones.
+#define LIST_LATENCY_BUCKETS 32
+
+// Counters of one List, or of every List together.
+typedef struct ListStats {
+    unsigned long long nodes_allocated; // nodes taken from a pool
+    unsigned long long nodes_freed;     // nodes given back to a pool
+    unsigned long long cursor_steps;    // elements the cursor or a seek walked over
+    unsigned long long copies;          // copyList() calls on the List
+    unsigned long long concats;         // concatList() calls on the List
+    unsigned long long bytes_copied;    // bytes of its elements copied to new storage
+    unsigned long long calls[LIST_OPS];     // calls of each kind, in total only
+    unsigned long long sampled[LIST_OPS];   // of which timed, in total only
+    unsigned long long latency[LIST_OPS][LIST_LATENCY_BUCKETS];
+} ListStats;
+
+// listStats()
+// Fills *out with the counters of L, or with the totals of every List
+// since the program started if L is NULL. Calls and latencies are only
+// kept in total, and are 0 for a single List. Totals are summed over the
+// threads without stopping them, so they may lag a concurrent change.
+// Pre: out != NULL
+void listStats(List L, ListStats* out);
+
+// printListStats()
+// Prints the counters of S to out as text, one per line, followed by the
+// calls, median and 99th percentile latency, and histogram of every kind
+// of operation that was timed.
+// Pre: out != NULL, S != NULL
+void printListStats(FILE* out, const ListStats* S);
+
+// printListStatsJSON()
+// Prints the counters of S to out as one JSON object on a line. Every kind
+// of operation called appears under "operations" with its calls, sampled
+// calls and "latency_ns", a list of [lower bound, count] pairs for the
+// buckets that are not empty.
+// Pre: out != NULL, S != NULL
+void printListStatsJSON(FILE* out, const ListStats* S);
+
+#endif
+
+// With LIST_UNCHECKED, length(), index(), front(), back(), get() and the
+// cursor moves other than moveTo() are static inline functions defined in
+// ListInline.h, and preconditions are only assert()ed.
+#ifdef LIST_UNCHECKED
+#include "ListInline.h"
+#endif
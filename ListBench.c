@@ -0,0 +1,111 @@
+/*
+ * File:   ListBench.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include "List.h"
+
+#define USAGE "Usage: ListBench [element count] [rounds]\n"
+
+#ifdef LIST_UNCHECKED
+#define MODE "unchecked"
+#else
+#define MODE "checked"
+#endif
+
+// elapsed()
+// Returns the seconds from start to now.
+double elapsed(struct timespec start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// report()
+// Prints the time per element of a test on a List of the given storage
+// that visited n elements.
+void report(const char* storage, const char* test, double seconds, long long n) {
+	printf("%-9s %-8s %-10s %8.2f ns/element\n", MODE, storage, test, seconds * 1e9 / n);
+}
+
+// bench()
+// Runs every test on A, an empty List of the given storage, with n mostly
+// increasing ids over rounds rounds, and frees it. Returns a checksum.
+long long bench(List A, const char* storage, int n, int rounds) {
+	struct timespec start;
+	long long sum = 0;
+	unsigned id = 0;
+
+	//----- append() one element at a time -----//
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < n; i++) {
+		id += 1 + ((unsigned)i * 2654435761u >> 28);
+		append(A, (int)id);
+	}
+	report(storage, "append", elapsed(start), n);
+
+	//----- Forward cursor loop, as Lex prints -----//
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		for (moveFront(A); index(A) >= 0; moveNext(A)) {
+			sum += get(A);
+		}
+	}
+	report(storage, "forward", elapsed(start), (long long)n * rounds);
+
+	//----- Backward cursor loop -----//
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		for (moveBack(A); index(A) >= 0; movePrev(A)) {
+			sum += get(A);
+		}
+	}
+	report(storage, "backward", elapsed(start), (long long)n * rounds);
+
+	//----- Memory held -----//
+	printf("%-9s %-8s %-10s %8.2f bytes/element\n", MODE, storage, "memory",
+		(double)listBytes(A) / n);
+	freeList(&A);
+	return sum;
+}
+
+int main(int argc, char* argv[]) {
+	int n = 1000000;
+	int rounds = 20;
+	char* end;
+	if (argc > 3) {
+		fprintf(stderr, USAGE);
+		exit(EXIT_FAILURE);
+	}
+	if (argc > 1) {
+		n = (int)strtol(argv[1], &end, 10);
+		if (end == argv[1] || *end != '\0' || n < 1) {
+			fprintf(stderr, "Error: invalid element count '%s'\n", argv[1]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (argc > 2) {
+		rounds = (int)strtol(argv[2], &end, 10);
+		if (end == argv[2] || *end != '\0' || rounds < 1) {
+			fprintf(stderr, "Error: invalid round count '%s'\n", argv[2]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	long long sum = bench(newList(), "plain", n, rounds);
+	sum += bench(newPackedList(), "compact", n, rounds);
+	// printing the checksum keeps the loops from being optimized away
+	printf("%-9s checksum   %lld\n", MODE, sum);
+#ifdef LIST_STATS
+	// what the Lists did to get there, from a -DLIST_STATS build
+	ListStats stats;
+	listStats(NULL, &stats);
+	printListStats(stdout, &stats);
+#endif
+	return 0;
+}
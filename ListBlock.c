@@ -0,0 +1,2362 @@
+/*
+ * File:   ListBlock.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ * Unrolled implementation of List.h. Elements are kept in fixed size
+ * blocks of ints that are linked front to back, so traversals touch one
+ * cache line per several elements instead of one per element. Build this
+ * file in place of List.c to select it; clients are unchanged.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<limits.h>
+#include<assert.h>
+#include<pthread.h>
+
+// Selects the block layout of ListInline.h.
+#ifndef LIST_BLOCK
+#define LIST_BLOCK
+#endif
+
+#include "List.h"
+#include "ListInline.h"
+#include "ListPack.h"
+#include "ListScan.h"
+#include "Writer.h"
+#include "ListStats.h"
+
+// private Block type
+typedef BlockObj* Block;
+
+// Blocks are carved out of chunks owned by a pool. The first chunk holds
+// POOL_MIN_CHUNK blocks and each later one doubles, up to POOL_MAX_CHUNK.
+#define POOL_MIN_CHUNK 4
+#define POOL_MAX_CHUNK 256
+
+// private ChunkObj type
+typedef struct ChunkObj {
+    struct ChunkObj* next;
+    BlockObj blocks[];
+} ChunkObj;
+
+// private Chunk type
+typedef ChunkObj* Chunk;
+
+// private PoolObj type
+typedef struct PoolObj {
+    Chunk chunks;   // every chunk owned by the pool, newest first
+    Chunk oldest;   // last chunk of chunks
+    Block free;     // recycled blocks, linked through next
+    Block free_last; // last block of free, if free is not NULL
+    int used;       // blocks handed out from the newest chunk
+    int size;       // capacity of the newest chunk
+    int refs;       // number of Lists drawing blocks from the pool
+} PoolObj;
+
+// private Pool type
+typedef PoolObj* Pool;
+
+// The positional skip index has at most SKIP_MAX_LEVEL levels above the
+// block chain; a block gets a tower one level taller with probability 1/4.
+// Cursor moves of fewer than SKIP_WALK elements are walked, not searched.
+#define SKIP_MAX_LEVEL 16
+#define SKIP_WALK (8 * BLOCK_CAP)
+
+// private TowerObj type
+// An entry of the positional skip index standing over one block. link[k]
+// leads to the next tower that reaches level k, width elements further on.
+typedef struct TowerObj {
+    Block block;
+    int height;
+    struct {
+        struct TowerObj* next;
+        int width;
+    } link[];
+} TowerObj;
+
+// private Tower type
+typedef TowerObj* Tower;
+
+// private ShareObj type
+// Counts the Lists holding one chain of blocks, after copyList() has handed
+// out snapshots of it. Whichever changes the chain first copies it.
+typedef struct ShareObj {
+    int refs;
+} ShareObj;
+
+// private ListIterObj type
+typedef struct ListIterObj {
+    List list;
+    Block block;        // block holding the element under the iterator
+    int offset;         // position of that element within its block
+    int index;          // -1 if undefined
+    unsigned version;   // version of list when the traversal began
+    int decoded;        // block of a compact list held in buffer, -1 if none
+    int* buffer;        // PACK_BLOCK decoded elements, NULL until needed
+} ListIterObj;
+
+// private LockObj type
+// The reader-writer lock of a List. Waiting writers go first, so that a
+// steady stream of readers cannot starve them, which pthread_rwlock_t
+// allows on glibc.
+typedef struct LockObj {
+    pthread_mutex_t mutex;
+    pthread_cond_t readable;    // signaled when no writer holds or awaits L
+    pthread_cond_t writable;    // signaled when the lock falls free
+    int readers;                // threads holding a read lock
+    int writers;                // threads holding or awaiting the write lock
+    int writing;                // true (1) while the write lock is held
+} LockObj;
+
+// The lock of a List sits right after its ListObj, in the same allocation,
+// so that ListInline.h and its clients need no POSIX types.
+#define LIST_LOCK(L) ((LockObj*)((L) + 1))
+
+// With LIST_STATS the counters of a List follow its lock.
+#define LIST_COUNTS(L) ((unsigned long long*)(LIST_LOCK(L) + 1))
+
+// FAIL_IF()
+// Reports msg and exits if the precondition failure cond holds. With
+// LIST_UNCHECKED it is only an assert(), which NDEBUG compiles out.
+#ifdef LIST_UNCHECKED
+#define FAIL_IF(cond, msg) assert(!(cond))
+#else
+#define FAIL_IF(cond, msg) do { if (cond) { fputs(msg, stderr); exit(EXIT_FAILURE); } } while (0)
+#endif
+
+#ifdef LIST_SHARED_POOL
+// With LIST_SHARED_POOL every List created on a thread draws from that
+// thread's pool. The extra reference keeps it alive for the whole thread,
+// so such Lists must not be handed to another thread.
+static _Thread_local PoolObj thread_pool = { NULL, NULL, NULL, NULL, 0, 0, 1 };
+#endif
+
+// Reference counts -----------------------------------------------------------
+
+// The refs of a pool or share record are counted by every List holding it,
+// and a List and its snapshots from copyList() may each be used on another
+// thread under a lock of its own, so refs are only changed atomically. The
+// last holder is the one whose dropRef() takes the count to zero; one that
+// finds itself the only holder, with soleRef(), may then change what the
+// others let go of, as their changes happen before.
+
+// holdRef()
+// Adds a holder to the count at refs, on behalf of one who holds it already.
+static inline void holdRef(int* refs) {
+    __atomic_fetch_add(refs, 1, __ATOMIC_RELAXED);
+}
+
+// dropRef()
+// Drops a holder from the count at refs. Returns true (1) iff it was the
+// last one.
+static inline int dropRef(int* refs) {
+    return __atomic_fetch_sub(refs, 1, __ATOMIC_ACQ_REL) == 1;
+}
+
+// soleRef()
+// Returns true (1) iff the caller is the only holder counted at refs.
+static inline int soleRef(int* refs) {
+    return __atomic_load_n(refs, __ATOMIC_ACQUIRE) == 1;
+}
+
+// Pool functions -------------------------------------------------------------
+
+// newPool()
+// Returns reference to a new pool holding no chunks.
+Pool newPool(void) {
+#ifdef LIST_SHARED_POOL
+    holdRef(&thread_pool.refs);
+    return &thread_pool;
+#else
+    Pool P = malloc(sizeof(PoolObj));
+    P->chunks = NULL;
+    P->oldest = NULL;
+    P->free = NULL;
+    P->free_last = NULL;
+    P->used = 0;
+    P->size = 0;
+    P->refs = 1;
+    return(P);
+#endif
+}
+
+// resetPool()
+// Releases every chunk of P at once, invalidating all blocks carved from it.
+void resetPool(Pool P) {
+    Chunk C = P->chunks;
+    while (C != NULL) {
+        Chunk D = C->next;
+        free(C);
+        C = D;
+    }
+    P->chunks = NULL;
+    P->oldest = NULL;
+    P->free = NULL;
+    P->free_last = NULL;
+    P->used = 0;
+    P->size = 0;
+}
+
+// releasePool()
+// Drops one reference to *pP, freeing the pool with the last one, and
+// sets *pP to NULL.
+void releasePool(Pool* pP) {
+    if (pP != NULL && *pP != NULL) {
+        if (dropRef(&(*pP)->refs)) {
+            resetPool(*pP);
+            free(*pP);
+        }
+        *pP = NULL;
+    }
+}
+
+// mergePool()
+// Moves every chunk and recycled block of Q into P, leaving Q empty. Blocks
+// carved from Q stay valid and now belong to P.
+void mergePool(Pool P, Pool Q) {
+    if (Q->chunks == NULL) {
+        return;
+    }
+    if (P->chunks == NULL) {
+        P->chunks = Q->chunks;
+        P->used = Q->used;
+        P->size = Q->size;
+    }
+    else {
+        P->oldest->next = Q->chunks;
+    }
+    P->oldest = Q->oldest;
+    if (Q->free != NULL) {
+        if (P->free == NULL) {
+            P->free_last = Q->free_last;
+        }
+        Q->free_last->next = P->free;
+        P->free = Q->free;
+    }
+    Q->chunks = NULL;
+    Q->oldest = NULL;
+    Q->free = NULL;
+    Q->free_last = NULL;
+    Q->used = 0;
+    Q->size = 0;
+}
+
+// Block functions ------------------------------------------------------------
+
+// freeBlock()
+// Returns the block pointed to by *pB to the free list of P, sets *pB to NULL.
+void freeBlock(Pool P, Block* pB) {
+    if (pB != NULL && *pB != NULL) {
+        if (P->free == NULL) {
+            P->free_last = *pB;
+        }
+        (*pB)->next = P->free;
+        P->free = *pB;
+        *pB = NULL;
+    }
+}
+
+// newBlock()
+// Returns reference to a new empty Block taken from P.
+Block newBlock(Pool P) {
+    Block B;
+    if (P->free != NULL) {
+        B = P->free;
+        P->free = B->next;
+    }
+    else {
+        if (P->chunks == NULL || P->used == P->size) {
+            int size = P->size * 2;
+            if (size < POOL_MIN_CHUNK) size = POOL_MIN_CHUNK;
+            if (size > POOL_MAX_CHUNK) size = POOL_MAX_CHUNK;
+            Chunk C = malloc(sizeof(ChunkObj) + size * sizeof(BlockObj));
+            C->next = P->chunks;
+            if (P->chunks == NULL) {
+                P->oldest = C;
+            }
+            P->chunks = C;
+            P->used = 0;
+            P->size = size;
+        }
+        B = &P->chunks->blocks[P->used++];
+    }
+    B->next = NULL;
+    B->prev = NULL;
+    B->count = 0;
+    return(B);
+}
+
+// linkAfter()
+// Links block C into L directly after block B, or at the front if B is NULL.
+void linkAfter(List L, Block B, Block C) {
+    C->prev = B;
+    if (B == NULL) {
+        C->next = L->front;
+        L->front = C;
+    }
+    else {
+        C->next = B->next;
+        B->next = C;
+    }
+    if (C->next == NULL) {
+        L->back = C;
+    }
+    else {
+        C->next->prev = C;
+    }
+}
+
+// unlinkBlock()
+// Removes block B from L and returns it to the pool.
+void unlinkBlock(List L, Block B) {
+    if (B->prev == NULL) {
+        L->front = B->next;
+    }
+    else {
+        B->prev->next = B->next;
+    }
+    if (B->next == NULL) {
+        L->back = B->prev;
+    }
+    else {
+        B->next->prev = B->prev;
+    }
+    freeBlock(L->pool, &B);
+    STAT_ADD(L, STAT_NODES_FREED, 1);
+}
+
+// countBlocks()
+// Returns the number of blocks of L.
+int countBlocks(List L) {
+    int n = 0;
+    for (Block B = L->front; B != NULL; B = B->next) {
+        n++;
+    }
+    return n;
+}
+
+// Skip index functions -------------------------------------------------------
+
+// The index is an indexable skip list over the blocks of L, with link widths
+// counted in elements. It is built the first time a positional lookup needs
+// it and then kept up to date by every insertion and deletion, so moveTo(),
+// getAt() and the positional updates they imply are O(log n). Lists that
+// never seek pay nothing for it.
+
+// newTower()
+// Returns reference to a new Tower over B with room for height levels.
+Tower newTower(Block B, int height) {
+    Tower T = malloc(sizeof(TowerObj) + height * sizeof(T->link[0]));
+    T->block = B;
+    T->height = height;
+    for (int k = 0; k < height; k++) {
+        T->link[k].next = NULL;
+        T->link[k].width = 0;
+    }
+    return(T);
+}
+
+// skipHeight()
+// Returns a random tower height for L, 0 for three blocks in four.
+int skipHeight(List L) {
+    unsigned r = L->skip_seed;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    L->skip_seed = r;
+    int h = 0;
+    while ((r & 3) == 0 && h < SKIP_MAX_LEVEL) {
+        h++;
+        r >>= 2;
+    }
+    return h;
+}
+
+// freeSkip()
+// Frees the positional index of L, if any.
+void freeSkip(List L) {
+    Tower T = L->skip;
+    while (T != NULL) {
+        Tower U = T->link[0].next;
+        free(T);
+        T = U;
+    }
+    L->skip = NULL;
+}
+
+// buildSkip()
+// Builds the positional index of L in a single pass over its blocks.
+void buildSkip(List L) {
+    Tower last[SKIP_MAX_LEVEL];
+    int last_pos[SKIP_MAX_LEVEL];
+    L->skip = newTower(NULL, SKIP_MAX_LEVEL);
+    L->skip->height = 0;
+    for (int k = 0; k < SKIP_MAX_LEVEL; k++) {
+        last[k] = L->skip;
+        last_pos[k] = 0;
+    }
+    int pos = 0;
+    for (Block B = L->front; B != NULL; pos += B->count, B = B->next) {
+        int h = skipHeight(L);
+        if (h == 0) continue;
+        Tower T = newTower(B, h);
+        for (int k = 0; k < h; k++) {
+            last[k]->link[k].next = T;
+            last[k]->link[k].width = pos - last_pos[k];
+            last[k] = T;
+            last_pos[k] = pos;
+        }
+        if (h > L->skip->height) {
+            L->skip->height = h;
+        }
+    }
+}
+
+// skipPath()
+// Fills update[k] with the last tower reaching level k that lies before
+// position pos, and update_pos[k] with its position. If through is not
+// NULL, a tower over the block through starting at pos counts as before it.
+void skipPath(List L, int pos, Block through, Tower* update, int* update_pos) {
+    Tower T = L->skip;
+    int p = 0;
+    for (int k = L->skip->height - 1; k >= 0; k--) {
+        while (T->link[k].next != NULL) {
+            int q = p + T->link[k].width;
+            if (q > pos || (q == pos && T->link[k].next->block != through)) {
+                break;
+            }
+            p = q;
+            T = T->link[k].next;
+        }
+        update[k] = T;
+        update_pos[k] = p;
+    }
+}
+
+// skipResize()
+// Records in the index of L that block B, starting at position pos,
+// gained delta elements.
+void skipResize(List L, int pos, Block B, int delta) {
+    Tower update[SKIP_MAX_LEVEL];
+    int update_pos[SKIP_MAX_LEVEL];
+    skipPath(L, pos, B, update, update_pos);
+    for (int k = 0; k < L->skip->height; k++) {
+        if (update[k]->link[k].next != NULL) {
+            update[k]->link[k].width += delta;
+        }
+    }
+}
+
+// skipLink()
+// Records in the index of L that block B was linked in at position pos.
+void skipLink(List L, int pos, Block B) {
+    Tower update[SKIP_MAX_LEVEL];
+    int update_pos[SKIP_MAX_LEVEL];
+    int h = skipHeight(L);
+    if (h == 0) return;
+    Tower T = newTower(B, h);
+    while (L->skip->height < h) {
+        L->skip->link[L->skip->height].next = NULL;
+        L->skip->height++;
+    }
+    skipPath(L, pos, NULL, update, update_pos);
+    for (int k = 0; k < h; k++) {
+        Tower U = update[k];
+        T->link[k].next = U->link[k].next;
+        T->link[k].width = update_pos[k] + U->link[k].width - pos;
+        U->link[k].next = T;
+        U->link[k].width = pos - update_pos[k];
+    }
+}
+
+// skipUnlink()
+// Records in the index of L that block B at position pos is being unlinked.
+void skipUnlink(List L, int pos, Block B) {
+    Tower update[SKIP_MAX_LEVEL];
+    int update_pos[SKIP_MAX_LEVEL];
+    Tower T = NULL;
+    skipPath(L, pos, NULL, update, update_pos);
+    for (int k = 0; k < L->skip->height; k++) {
+        Tower U = update[k];
+        if (U->link[k].next != NULL && U->link[k].next->block == B) {
+            T = U->link[k].next;
+            U->link[k].width += T->link[k].width;
+            U->link[k].next = T->link[k].next;
+        }
+    }
+    free(T);
+}
+
+// locate()
+// Finds the block and offset of position i of L, walking from whichever of
+// the cursor, front and back is close enough, and searching the index
+// otherwise.
+void locate(List L, int i, Block* pB, int* po) {
+    Block B;
+    int p;
+    if (i < SKIP_WALK) {
+        B = L->front;
+        p = 0;
+    }
+    else if (L->length - 1 - i < SKIP_WALK) {
+        B = L->back;
+        p = L->length - B->count;
+    }
+    else if (L->cursor_index >= 0 && abs(i - L->cursor_index) < SKIP_WALK) {
+        B = L->cursor;
+        p = L->cursor_index - L->cursor_offset;
+    }
+    else {
+        if (L->skip == NULL) {
+            buildSkip(L);
+        }
+        Tower T = L->skip;
+        p = 0;
+        for (int k = L->skip->height - 1; k >= 0; k--) {
+            while (T->link[k].next != NULL && p + T->link[k].width <= i) {
+                p += T->link[k].width;
+                T = T->link[k].next;
+            }
+        }
+        B = (T->block != NULL ? T->block : L->front);
+    }
+    STAT_ADD(L, STAT_CURSOR_STEPS, abs(i - p));
+    while (i >= p + B->count) {
+        p += B->count;
+        B = B->next;
+    }
+    while (i < p) {
+        B = B->prev;
+        p -= B->count;
+    }
+    *pB = B;
+    *po = i - p;
+}
+
+// Sorted search functions ----------------------------------------------------
+
+// precedes()
+// Returns true (1) iff e comes before the bound of x under cmp: if it is
+// less than x, or not greater than x when strict is true.
+int precedes(int e, int x, int strict, int (*cmp)(int, int, void*), void* ctx) {
+    int c = cmp(e, x, ctx);
+    return (strict ? c <= 0 : c < 0);
+}
+
+// packBound()
+// Returns the position of the first element of the compact List L that
+// does not precede the bound of x, by binary search.
+int packBound(List L, int x, int strict, int (*cmp)(int, int, void*), void* ctx) {
+    int lo = 0;
+    int hi = L->length;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (precedes(packGet(L->pack, mid), x, strict, cmp, ctx)) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// blockBound()
+// Returns the offset of the first element of block B that does not precede
+// the bound of x, by binary search, or B->count if they all do.
+int blockBound(Block B, int x, int strict, int (*cmp)(int, int, void*), void* ctx) {
+    int lo = 0;
+    int hi = B->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (precedes(B->data[mid], x, strict, cmp, ctx)) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// seekBound()
+// Returns the position of the first element of L, sorted under cmp, that
+// does not precede the bound of x, and sets *pB and *po to its block and
+// offset, *pB to NULL if there is none. Walks whole blocks from the cursor
+// when the bound lies within SKIP_WALK elements of it, and otherwise
+// descends the positional index comparing first elements, as skip list
+// searches do; either way the bound is then found within its block by
+// binary search.
+int seekBound(List L, int x, int strict, int (*cmp)(int, int, void*), void* ctx,
+              Block* pB, int* po) {
+    Block B = L->cursor;
+    int p = L->cursor_index - L->cursor_offset;
+    if (B != NULL) {
+        if (precedes(B->data[L->cursor_offset], x, strict, cmp, ctx)) {
+            for (int walked = 0; B != NULL && walked < SKIP_WALK; B = B->next) {
+                if (!precedes(B->data[B->count - 1], x, strict, cmp, ctx)) {
+                    *pB = B;
+                    *po = blockBound(B, x, strict, cmp, ctx);
+                    return p + *po;
+                }
+                walked += B->count;
+                STAT_ADD(L, STAT_CURSOR_STEPS, B->count);
+                p += B->count;
+            }
+            if (B == NULL) {
+                *pB = NULL;
+                *po = 0;
+                return p;
+            }
+        }
+        else {
+            for (int walked = 0; walked < SKIP_WALK; B = B->prev) {
+                if (B->prev == NULL ||
+                    precedes(B->prev->data[B->prev->count - 1], x, strict, cmp, ctx)) {
+                    *pB = B;
+                    *po = blockBound(B, x, strict, cmp, ctx);
+                    return p + *po;
+                }
+                walked += B->count;
+                STAT_ADD(L, STAT_CURSOR_STEPS, B->count);
+                p -= B->prev->count;
+            }
+        }
+    }
+    B = L->front;
+    p = 0;
+    if (L->length > SKIP_WALK) {
+        if (L->skip == NULL) {
+            buildSkip(L);
+        }
+        Tower T = L->skip;
+        for (int k = L->skip->height - 1; k >= 0; k--) {
+            while (T->link[k].next != NULL &&
+                   precedes(T->link[k].next->block->data[0], x, strict, cmp, ctx)) {
+                p += T->link[k].width;
+                T = T->link[k].next;
+            }
+        }
+        if (T->block != NULL) {
+            B = T->block;
+        }
+    }
+    while (B != NULL && precedes(B->data[B->count - 1], x, strict, cmp, ctx)) {
+        STAT_ADD(L, STAT_CURSOR_STEPS, B->count);
+        p += B->count;
+        B = B->next;
+    }
+    *pB = B;
+    *po = (B != NULL ? blockBound(B, x, strict, cmp, ctx) : 0);
+    return p + *po;
+}
+
+// Sharing functions ----------------------------------------------------------
+
+// copyList() shares the blocks of a List with the copy instead of copying
+// them. Every operation that changes the blocks of a List first calls
+// materialize(), which gives it a private copy if the chain is still shared.
+// Blocks are linked both ways, so the chain is shared or copied as a whole;
+// copying it costs one memcpy() per block. A compact List is never shared;
+// materialize() decodes it into blocks. Either way materialize() bumps the
+// version of the List, invalidating its ListIters.
+
+// isShared()
+// Returns true (1) iff the blocks of L are shared with another List,
+// dropping the share record of L if every other holder has let go of them.
+int isShared(List L) {
+    if (L->share != NULL && soleRef(&L->share->refs)) {
+        free(L->share);
+        L->share = NULL;
+    }
+    return L->share != NULL;
+}
+
+// dropShare()
+// Lets go of the share record of L, freeing it if L was its last holder.
+void dropShare(List L) {
+    if (dropRef(&L->share->refs)) {
+        free(L->share);
+    }
+    L->share = NULL;
+}
+
+// materialize()
+// Gives L a private copy of its blocks, in a pool of its own, if it shares
+// them with another List, and ordinary full blocks if it is compact. The
+// cursor stays on the same element; the positional index is dropped.
+void materialize(List L) {
+    L->version++;
+    if (L->pack != NULL) {
+        STAT_ADD(L, STAT_BYTES_COPIED, L->length * sizeof(int));
+        for (int i = 0; i < L->length; i += BLOCK_CAP) {
+            Block B = newBlock(L->pool);
+            STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+            B->count = (L->length - i < BLOCK_CAP ? L->length - i : BLOCK_CAP);
+            for (int j = 0; j < B->count; j++) {
+                B->data[j] = packGet(L->pack, i + j);
+            }
+            linkAfter(L, L->back, B);
+            if (L->cursor_index >= i && L->cursor_index < i + B->count) {
+                L->cursor = B;
+                L->cursor_offset = L->cursor_index - i;
+            }
+        }
+        freePack(&L->pack);
+        return;
+    }
+    if (!isShared(L)) {
+        return;
+    }
+    Pool P = newPool();
+    Block first = NULL;
+    Block last = NULL;
+    Block cursor = NULL;
+    STAT_ADD(L, STAT_BYTES_COPIED, L->length * sizeof(int));
+    for (Block B = L->front; B != NULL; B = B->next) {
+        Block C = newBlock(P);
+        STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+        memcpy(C->data, B->data, B->count * sizeof(int));
+        C->count = B->count;
+        C->prev = last;
+        if (last == NULL) {
+            first = C;
+        }
+        else {
+            last->next = C;
+        }
+        last = C;
+        if (B == L->cursor) {
+            cursor = C;
+        }
+    }
+    releasePool(&L->pool);
+    L->pool = P;
+    dropShare(L);
+    L->front = first;
+    L->back = last;
+    L->cursor = cursor;
+    freeSkip(L);
+}
+
+// Hash functions -------------------------------------------------------------
+
+// The fingerprint of a List of the n elements e_0 ... e_(n-1) is the sum of
+// mixElement(e_i) * HASH_BASE^(n-1-i), mod 2^64. Appending multiplies it by
+// HASH_BASE before adding the new term, prepending adds the new term times
+// HASH_BASE^n, and deleting at either end undoes one or the other, which
+// HASH_BASE, being odd, allows. Any other change marks it stale by zeroing
+// hash_power, which no power of HASH_BASE is, and listHash() recomputes it.
+#define HASH_BASE 0x100000001b3ULL
+#define HASH_BASE_INVERSE 0xce965057aff6957bULL
+
+// mixElement()
+// Returns the term of x in a fingerprint, its 32 bits spread over all 64.
+unsigned long long mixElement(int x) {
+    unsigned long long z = (unsigned)x + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// hashAppend()
+// Updates the fingerprint of L for x appended after its back element.
+void hashAppend(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash = L->hash * HASH_BASE + mixElement(x);
+        L->hash_power *= HASH_BASE;
+    }
+}
+
+// hashPrepend()
+// Updates the fingerprint of L for x inserted before its front element.
+void hashPrepend(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash += mixElement(x) * L->hash_power;
+        L->hash_power *= HASH_BASE;
+    }
+}
+
+// hashDeleteFront()
+// Updates the fingerprint of L for its front element x deleted.
+void hashDeleteFront(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash_power *= HASH_BASE_INVERSE;
+        L->hash -= mixElement(x) * L->hash_power;
+    }
+}
+
+// hashDeleteBack()
+// Updates the fingerprint of L for its back element x deleted.
+void hashDeleteBack(List L, int x) {
+    if (L->hash_power != 0) {
+        L->hash = (L->hash - mixElement(x)) * HASH_BASE_INVERSE;
+        L->hash_power *= HASH_BASE_INVERSE;
+    }
+}
+
+// hashJoin()
+// Updates the fingerprint of L for the elements of S appended after its
+// back element. S may be L.
+void hashJoin(List L, List S) {
+    unsigned long long h = S->hash;
+    unsigned long long p = S->hash_power;
+    if (L->hash_power != 0 && p != 0) {
+        L->hash = L->hash * p + h;
+        L->hash_power *= p;
+    }
+    else {
+        L->hash_power = 0;
+    }
+}
+
+// Element functions ----------------------------------------------------------
+
+// insertBlock()
+// Links block C into L after block B, or at the front if B is NULL. C must
+// start at position pos.
+void insertBlock(List L, Block B, Block C, int pos) {
+    linkAfter(L, B, C);
+    if (L->skip != NULL) {
+        skipLink(L, pos, C);
+    }
+}
+
+// removeBlock()
+// Unlinks block B, starting at position pos, from L and frees it.
+void removeBlock(List L, Block B, int pos) {
+    if (L->skip != NULL) {
+        skipUnlink(L, pos, B);
+    }
+    unlinkBlock(L, B);
+}
+
+// insertAt()
+// Inserts data at offset o of block B, which starts at position pos,
+// splitting B first if it is full. The cursor stays on its element;
+// cursor_index is left to the caller.
+void insertAt(List L, Block B, int o, int data, int pos) {
+    if (B->count == BLOCK_CAP) {
+        int keep = BLOCK_CAP / 2;
+        Block C = newBlock(L->pool);
+        STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+        C->count = BLOCK_CAP - keep;
+        memcpy(C->data, B->data + keep, C->count * sizeof(int));
+        B->count = keep;
+        insertBlock(L, B, C, pos + keep);
+        if (L->cursor == B && L->cursor_offset >= keep) {
+            L->cursor = C;
+            L->cursor_offset -= keep;
+        }
+        if (o > keep) {
+            B = C;
+            o -= keep;
+            pos += keep;
+        }
+    }
+    memmove(B->data + o + 1, B->data + o, (B->count - o) * sizeof(int));
+    B->data[o] = data;
+    B->count++;
+    if (L->cursor == B && L->cursor_offset >= o) {
+        L->cursor_offset++;
+    }
+    L->length++;
+    if (L->skip != NULL) {
+        skipResize(L, pos, B, 1);
+    }
+}
+
+// mergeNext()
+// Moves every element of the block after B into B and frees that block.
+// B must start at position pos.
+void mergeNext(List L, Block B, int pos) {
+    Block N = B->next;
+    memcpy(B->data + B->count, N->data, N->count * sizeof(int));
+    if (L->cursor == N) {
+        L->cursor = B;
+        L->cursor_offset += B->count;
+    }
+    B->count += N->count;
+    removeBlock(L, N, pos + B->count - N->count);
+}
+
+// removeAt()
+// Removes the element at offset o of block B, which starts at position pos.
+// If it was the cursor element the cursor becomes undefined; otherwise
+// cursor_index is left to the caller. Blocks that drop to half full or less
+// together with a neighbour are merged.
+void removeAt(List L, Block B, int o, int pos) {
+    memmove(B->data + o, B->data + o + 1, (B->count - o - 1) * sizeof(int));
+    B->count--;
+    L->length--;
+    if (L->skip != NULL) {
+        skipResize(L, pos, B, -1);
+    }
+    if (L->cursor == B) {
+        if (L->cursor_offset == o) {
+            L->cursor = NULL;
+            L->cursor_index = -1;
+        }
+        else if (L->cursor_offset > o) {
+            L->cursor_offset--;
+        }
+    }
+    if (B->count == 0) {
+        removeBlock(L, B, pos);
+    }
+    else if (B->next != NULL && B->count + B->next->count <= BLOCK_CAP / 2) {
+        mergeNext(L, B, pos);
+    }
+    else if (B->prev != NULL && B->count + B->prev->count <= BLOCK_CAP / 2) {
+        mergeNext(L, B->prev, pos - B->prev->count);
+    }
+}
+
+// appendData()
+// Appends the n elements of data to L, packing them into full blocks.
+void appendData(List L, const int* data, int n) {
+    while (n > 0) {
+        if (L->back == NULL || L->back->count == BLOCK_CAP) {
+            insertBlock(L, L->back, newBlock(L->pool), L->length);
+            STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+        }
+        Block B = L->back;
+        int k = BLOCK_CAP - B->count;
+        if (k > n) k = n;
+        memcpy(B->data + B->count, data, k * sizeof(int));
+        if (L->skip != NULL) {
+            skipResize(L, L->length - B->count, B, k);
+        }
+        B->count += k;
+        L->length += k;
+        data += k;
+        n -= k;
+    }
+}
+
+// appendCopy()
+// Appends a copy of every element of S to L, a List other than S.
+void appendCopy(List L, List S) {
+    hashJoin(L, S);
+    STAT_ADD(S, STAT_BYTES_COPIED, S->length * sizeof(int));
+    if (S->pack != NULL) {
+        int buffer[PACK_BLOCK];
+        for (int i = 0; i < S->length; i += PACK_BLOCK) {
+            int k = (S->length - i < PACK_BLOCK ? S->length - i : PACK_BLOCK);
+            for (int j = 0; j < k; j++) {
+                buffer[j] = packGet(S->pack, i + j);
+            }
+            appendData(L, buffer, k);
+        }
+        return;
+    }
+    for (Block B = S->front; B != NULL; B = B->next) {
+        appendData(L, B->data, B->count);
+    }
+}
+
+// joinPools()
+// Leaves L and S drawing from one pool, so that blocks of S may be linked
+// into L. If S is the only user of its pool, its chunks move into the pool
+// of L; otherwise, if L is the only user of its own, L moves over to the
+// pool of S. Returns false (0), changing nothing, if both pools are shared
+// with other Lists.
+int joinPools(List L, List S) {
+    Pool P = L->pool;
+    Pool Q = S->pool;
+    if (P == Q) {
+        return 1;
+    }
+    if (soleRef(&Q->refs)) {
+        mergePool(P, Q);
+        return 1;
+    }
+    if (soleRef(&P->refs)) {
+        mergePool(Q, P);
+        releasePool(&L->pool);
+        L->pool = Q;
+        holdRef(&Q->refs);
+        return 1;
+    }
+    return 0;
+}
+
+// takeBlocks()
+// Empties S, handing its blocks to L as a chain from *pFirst to *pLast, and
+// returns the number of elements in them. The blocks are relinked, not
+// copied, unless S shares them with another List or the pools of L and S
+// cannot be joined. A compact S is decoded first. S must not be empty.
+int takeBlocks(List L, List S, Block* pFirst, Block* pLast) {
+    int n = S->length;
+    if (S->pack != NULL) {
+        materialize(S);
+    }
+    if (!isShared(S) && joinPools(L, S)) {
+        *pFirst = S->front;
+        *pLast = S->back;
+        S->front = NULL;
+        S->back = NULL;
+        S->cursor = NULL;
+        S->length = 0;
+        S->cursor_index = -1;
+        S->version++;
+        S->hash = 0;
+        S->hash_power = 1;
+        freeSkip(S);
+        return n;
+    }
+    Block first = NULL;
+    Block last = NULL;
+    STAT_ADD(S, STAT_BYTES_COPIED, n * sizeof(int));
+    for (Block B = S->front; B != NULL; B = B->next) {
+        Block C = newBlock(L->pool);
+        STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+        memcpy(C->data, B->data, B->count * sizeof(int));
+        C->count = B->count;
+        C->prev = last;
+        if (last == NULL) {
+            first = C;
+        }
+        else {
+            last->next = C;
+        }
+        last = C;
+    }
+    clear(S);
+    *pFirst = first;
+    *pLast = last;
+    return n;
+}
+
+// cutAtCursor()
+// Splits the cursor block of L so that the cursor element starts a block,
+// and returns that block. L must have no positional index.
+Block cutAtCursor(List L) {
+    Block B = L->cursor;
+    int o = L->cursor_offset;
+    if (o == 0) {
+        return B;
+    }
+    Block C = newBlock(L->pool);
+    STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+    C->count = B->count - o;
+    memcpy(C->data, B->data + o, C->count * sizeof(int));
+    B->count = o;
+    linkAfter(L, B, C);
+    L->cursor = C;
+    L->cursor_offset = 0;
+    return C;
+}
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newList()
+// Returns reference to new empty List object.
+List newList(void) {
+    List L;
+    L = malloc(sizeof(ListObj) + sizeof(LockObj) + STAT_BYTES);
+    L->front = NULL;
+    L->back = NULL;
+    L->cursor = NULL;
+    L->cursor_offset = 0;
+    L->length = 0;
+    L->cursor_index = -1;
+    L->pool = newPool();
+    L->skip = NULL;
+    L->skip_seed = 0x9e3779b9;
+    L->share = NULL;
+    L->pack = NULL;
+    L->version = 0;
+    L->hash = 0;
+    L->hash_power = 1;
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_init(&K->mutex, NULL);
+    pthread_cond_init(&K->readable, NULL);
+    pthread_cond_init(&K->writable, NULL);
+    K->readers = 0;
+    K->writers = 0;
+    K->writing = 0;
+    STAT_INIT(L);
+    return(L);
+}
+
+// newListFromArray()
+// Returns reference to new List object holding the n elements of data,
+// in order. The cursor is undefined.
+// Pre: data != NULL if n > 0
+List newListFromArray(const int* data, size_t n) {
+    FAIL_IF(data == NULL && n > 0, "List Error: calling newListFromArray() on NULL array\n");
+    List L = newList();
+    appendArray(L, data, n);
+    return(L);
+}
+
+// newPackedList()
+// Returns reference to new empty List object in compact mode.
+List newPackedList(void) {
+    List L = newList();
+    L->pack = newPack();
+    return(L);
+}
+
+// loadList()
+// Returns reference to new List object holding the elements that
+// saveList() wrote to in, or NULL with errno set.
+// Pre: in != NULL
+List loadList(FILE* in) {
+    FAIL_IF(in == NULL, "File Error: calling loadList() on NULL file pointer\n");
+    STAT_TIME(LIST_OP_IO);
+    int n;
+    int* data = readListFile(in, &n);
+    if (data == NULL) {
+        return NULL;
+    }
+    List L = newListFromArray(data, n);
+    free(data);
+    return(L);
+}
+
+// mapList()
+// Returns reference to new List object over the elements that saveList()
+// wrote to the file named path, read in place from a read-only mapping,
+// or NULL with errno set.
+// Pre: path != NULL
+List mapList(const char* path) {
+    FAIL_IF(path == NULL, "List Error: calling mapList() on NULL path\n");
+    STAT_TIME(LIST_OP_IO);
+    int n;
+    Pack P = mapPack(path, &n);
+    if (P == NULL) {
+        return NULL;
+    }
+    List L = newList();
+    L->pack = P;
+    L->length = n;
+    L->hash_power = 0;
+    return(L);
+}
+
+// freeList()
+// Frees all heap memory associated with List *pL, and sets *pL to NULL.
+// Pre: List != NULL
+void freeList(List* pL) {
+    FAIL_IF(*pL == NULL, "List Error: calling freeList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_DELETE);
+    if (pL != NULL && *pL != NULL) {
+        clear(*pL);
+        releasePool(&(*pL)->pool);
+        freePack(&(*pL)->pack);
+        pthread_mutex_destroy(&LIST_LOCK(*pL)->mutex);
+        pthread_cond_destroy(&LIST_LOCK(*pL)->readable);
+        pthread_cond_destroy(&LIST_LOCK(*pL)->writable);
+        free(*pL);
+        *pL = NULL;
+    }
+    return;
+}
+
+// Access functions -----------------------------------------------------------
+
+#ifndef LIST_UNCHECKED
+
+// length()
+// Returns the number of elements in L.
+// Pre: List != NULL
+int length(List L) {
+    FAIL_IF(L == NULL, "List Error: calling length() on NULL List reference\n");
+    return L->length;
+}
+
+// index()
+// Returns index of cursor element if defined, -1 otherwise.
+// Pre: List != NULL
+int index(List L) {
+    FAIL_IF(L == NULL, "List Error: calling index() on NULL List reference\n");
+    if ((L->cursor_index) < 0 || (L->cursor == NULL && L->pack == NULL)) {
+        return -1;
+    }
+    else {
+        return L->cursor_index;
+    }
+}
+
+// front()
+// Returns front element of L. Pre: length()>0, List != NULL
+int front(List L) {
+    FAIL_IF(L == NULL, "List Error: calling front() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling front() on an empty List\n");
+    if (L->pack != NULL) {
+        return packGet(L->pack, 0);
+    }
+    return L->front->data[0];
+}
+
+// back()
+// Returns back element of L. Pre: length()>0, List != NULL
+int back(List L) {
+    FAIL_IF(L == NULL, "List Error: calling back() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling back() on an empty List\n");
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->length - 1);
+    }
+    return L->back->data[L->back->count - 1];
+}
+
+// get()
+// Returns cursor element of L. Pre: length()>0, index()>=0
+// Pre: List!= NULL, length() > 0, index() >= 0
+int get(List L) {
+    FAIL_IF(L == NULL, "List Error: calling get() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling get() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling get() on an undefined cursor element\n");
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->cursor_index);
+    }
+    return L->cursor->data[L->cursor_offset];
+}
+
+#endif
+
+// getAt()
+// Returns the element at position i of L without moving the cursor.
+// Pre: List != NULL, 0 <= i < length()
+int getAt(List L, int i) {
+    FAIL_IF(L == NULL, "List Error: calling getAt() on NULL List reference\n");
+    FAIL_IF(i < 0 || i >= L->length, "List Error: calling getAt() with an index out of range\n");
+    STAT_TIME(LIST_OP_SEEK);
+    if (L->pack != NULL) {
+        return packGet(L->pack, i);
+    }
+    Block B;
+    int o;
+    locate(L, i, &B, &o);
+    return B->data[o];
+}
+
+// toArray()
+// Copies the first n elements of L into out, front first, or all of them if
+// L is shorter. Returns the number of elements copied.
+// Pre: List != NULL, out != NULL if n > 0
+int toArray(List L, int* out, size_t n) {
+    FAIL_IF(L == NULL, "List Error: calling toArray() on NULL List reference\n");
+    FAIL_IF(out == NULL && n > 0, "List Error: calling toArray() on NULL array\n");
+    STAT_TIME(LIST_OP_SCAN);
+    int k = (n < (size_t)L->length ? (int)n : L->length);
+    if (L->pack != NULL) {
+        packDecode(L->pack, out, k);
+        return k;
+    }
+    int i = 0;
+    for (Block B = L->front; i < k; B = B->next) {
+        int c = (B->count < k - i ? B->count : k - i);
+        memcpy(out + i, B->data, c * sizeof(int));
+        i += c;
+    }
+    return k;
+}
+
+// find()
+// Sets the cursor under the first element of L equal to x and returns its
+// index, or returns -1, leaving the cursor as it was, if there is none.
+// Pre: List != NULL
+int find(List L, int x) {
+    FAIL_IF(L == NULL, "List Error: calling find() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        int i = packFind(L->pack, x);
+        if (i >= 0) {
+            L->cursor_index = i;
+        }
+        return i;
+    }
+    int p = 0;
+    for (Block B = L->front; B != NULL; p += B->count, B = B->next) {
+        int o = scanFind(B->data, B->count, x);
+        if (o >= 0) {
+            L->cursor = B;
+            L->cursor_offset = o;
+            L->cursor_index = p + o;
+            return p + o;
+        }
+    }
+    return -1;
+}
+
+// count()
+// Returns the number of elements of L equal to x.
+// Pre: List != NULL
+int count(List L, int x) {
+    FAIL_IF(L == NULL, "List Error: calling count() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packCount(L->pack, x);
+    }
+    int c = 0;
+    for (Block B = L->front; B != NULL; B = B->next) {
+        c += scanCount(B->data, B->count, x);
+    }
+    return c;
+}
+
+// sumList()
+// Returns the sum of the elements of L, 0 if it is empty.
+// Pre: List != NULL
+long long sumList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling sumList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packSum(L->pack);
+    }
+    long long s = 0;
+    for (Block B = L->front; B != NULL; B = B->next) {
+        s += scanSum(B->data, B->count);
+    }
+    return s;
+}
+
+// minList()
+// Returns the least element of L.
+// Pre: List != NULL, length() > 0
+int minList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling minList() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling minList() on an empty List\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packMin(L->pack);
+    }
+    int m = L->front->data[0];
+    for (Block B = L->front; B != NULL; B = B->next) {
+        int k = scanMin(B->data, B->count);
+        m = (k < m ? k : m);
+    }
+    return m;
+}
+
+// maxList()
+// Returns the greatest element of L.
+// Pre: List != NULL, length() > 0
+int maxList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling maxList() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling maxList() on an empty List\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->pack != NULL) {
+        return packMax(L->pack);
+    }
+    int m = L->front->data[0];
+    for (Block B = L->front; B != NULL; B = B->next) {
+        int k = scanMax(B->data, B->count);
+        m = (k > m ? k : m);
+    }
+    return m;
+}
+
+// listHash()
+// Returns the fingerprint of the elements of L, recomputing it first if it
+// is stale.
+// Pre: List != NULL
+unsigned long long listHash(List L) {
+    FAIL_IF(L == NULL, "List Error: calling listHash() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+    if (L->hash_power != 0) {
+        return L->hash;
+    }
+    L->hash = 0;
+    L->hash_power = 1;
+    if (L->pack != NULL) {
+        for (int i = 0; i < L->length; i++) {
+            hashAppend(L, packGet(L->pack, i));
+        }
+        return L->hash;
+    }
+    for (Block B = L->front; B != NULL; B = B->next) {
+        for (int i = 0; i < B->count; i++) {
+            hashAppend(L, B->data[i]);
+        }
+    }
+    return L->hash;
+}
+
+// equals()
+// Returns true (1) iff Lists A and B are in same
+// state, and returns false (0) otherwise. Lists whose
+// fingerprints differ are told apart in O(1) time.
+// Pre: List!= NULL
+int equals(List A, List B) {
+    int eq = 0;
+    Block N = NULL;
+    Block M = NULL;
+    int i = 0, j = 0;
+
+    FAIL_IF(A == NULL || B == NULL, "List Error: calling equals() on NULL List reference\n");
+    STAT_TIME(LIST_OP_SCAN);
+
+    eq = (A->length == B->length);
+    if (!eq || listHash(A) != listHash(B)) {
+        return 0;
+    }
+    if (A->pack != NULL && B->pack != NULL) {
+        return eq && packEquals(A->pack, B->pack);
+    }
+    if (A->pack != NULL || B->pack != NULL) {
+        Pack P = (A->pack != NULL ? A->pack : B->pack);
+        N = (A->pack != NULL ? B->front : A->front);
+        for (; eq && N != NULL; N = N->next) {
+            for (int k = 0; eq && k < N->count; k++) {
+                eq = (packGet(P, i++) == N->data[k]);
+            }
+        }
+        return eq;
+    }
+    if (eq && A->front == B->front) {
+        return eq;
+    }
+    N = A->front;
+    M = B->front;
+    while (eq && N != NULL)
+    {
+        int k = N->count - i;
+        if (k > M->count - j) k = M->count - j;
+        eq = (memcmp(N->data + i, M->data + j, k * sizeof(int)) == 0);
+        i += k;
+        j += k;
+        if (i == N->count) {
+            N = N->next;
+            i = 0;
+        }
+        if (j == M->count) {
+            M = M->next;
+            j = 0;
+        }
+    }
+    return eq;
+}
+
+// Manipulation procedures ----------------------------------------------------
+
+// clear()
+// Resets L to its original empty state.
+// Pre: List!= NULL
+void clear(List L) {
+    FAIL_IF(L == NULL, "List Error: calling clear() on NULL List reference\n");
+    STAT_TIME(LIST_OP_DELETE);
+    L->version++;
+    L->hash = 0;
+    L->hash_power = 1;
+    if (L->pack != NULL) {
+        clearPack(L->pack);
+        L->length = 0;
+        L->cursor_index = -1;
+        return;
+    }
+    if (isShared(L)) {
+        // the blocks live on in the other Lists, so just let go of them
+        releasePool(&L->pool);
+        L->pool = newPool();
+        dropShare(L);
+        L->length = 0;
+        L->front = NULL;
+        L->back = NULL;
+        L->cursor = NULL;
+        L->cursor_index = -1;
+    }
+    if (!(L->length == 0)) {
+        STAT_ADD(L, STAT_NODES_FREED, countBlocks(L));
+        if (soleRef(&L->pool->refs)) {
+            resetPool(L->pool);
+        }
+        else {
+            Block B = L->front;
+            while (B != NULL) {
+                Block C = B->next;
+                freeBlock(L->pool, &B);
+                B = C;
+            }
+        }
+        L->length = 0;
+        L->front = NULL;
+        L->back = NULL;
+        L->cursor = NULL;
+        L->cursor_index = -1;
+    }
+    freeSkip(L);
+    return;
+}
+
+#ifndef LIST_UNCHECKED
+
+// moveFront()
+// If L is non-empty, sets cursor under the front element,
+// otherwise does nothing.
+// Pre: List!= NULL
+void moveFront(List L) {
+    FAIL_IF(L == NULL, "List Error: calling moveFront() on NULL List reference\n");
+    if (L->length == 0) {
+        return;
+    }
+    L->cursor_index = 0;
+    L->cursor = L->front;
+    L->cursor_offset = 0;
+    return;
+}
+
+// moveBack()
+// If L is non-empty, sets cursor under the back element,
+// otherwise does nothing.
+// Pre: List!= NULL
+void moveBack(List L) {
+    FAIL_IF(L == NULL, "List Error: calling moveBack() on NULL List reference\n");
+    if (L->length == 0) {
+        return;
+    }
+    L->cursor_index = L->length - 1;
+    L->cursor = L->back;
+    L->cursor_offset = (L->pack != NULL ? 0 : L->back->count - 1);
+    return;
+}
+
+#endif
+
+// moveTo()
+// Sets cursor under the element at position i of L.
+// Pre: List != NULL, 0 <= i < length()
+void moveTo(List L, int i) {
+    FAIL_IF(L == NULL, "List Error: calling moveTo() on NULL List reference\n");
+    FAIL_IF(i < 0 || i >= L->length, "List Error: calling moveTo() with an index out of range\n");
+    STAT_TIME(LIST_OP_SEEK);
+    if (L->pack == NULL) {
+        locate(L, i, &L->cursor, &L->cursor_offset);
+    }
+    L->cursor_index = i;
+    return;
+}
+
+#ifndef LIST_UNCHECKED
+
+// movePrev()
+// If cursor is defined and not at front, move cursor one
+// step toward the front of L; if cursor is defined and at
+// front, cursor becomes undefined; if cursor is undefined
+// do nothing
+// Pre: List!= NULL
+void movePrev(List L) {
+    FAIL_IF(L == NULL, "List Error: calling movePrev() on NULL List reference\n");
+    if (L->cursor_index >= 0) {
+        STAT_ADD(L, STAT_CURSOR_STEPS, 1);
+    }
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0) {
+            L->cursor_index--;
+        }
+        return;
+    }
+    if (L->cursor_index == 0) {
+        L->cursor_index = -1;
+        L->cursor = NULL;
+    }
+    else if (L->cursor_index > 0) {
+        L->cursor_index--;
+        if (L->cursor_offset == 0) {
+            L->cursor = L->cursor->prev;
+            L->cursor_offset = L->cursor->count - 1;
+        }
+        else {
+            L->cursor_offset--;
+        }
+    }
+    return;
+}
+
+// moveNext()
+// If cursor is defined and not at back, move cursor one
+// step toward the back of L; if cursor is defined and at
+// back, cursor becomes undefined; if cursor is undefined
+// do nothing
+// Pre: List != NULL
+void moveNext(List L) {
+    FAIL_IF(L == NULL, "List Error: calling moveNext() on NULL List reference\n");
+    if (L->cursor_index >= 0) {
+        STAT_ADD(L, STAT_CURSOR_STEPS, 1);
+    }
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0 && ++L->cursor_index == L->length) {
+            L->cursor_index = -1;
+        }
+        return;
+    }
+    if (L->cursor_index == (L->length - 1)) {
+        L->cursor_index = -1;
+        L->cursor = NULL;
+    }
+    else if (L->cursor_index >= 0) {
+        L->cursor_index++;
+        if (++L->cursor_offset == L->cursor->count) {
+            L->cursor = L->cursor->next;
+            L->cursor_offset = 0;
+        }
+    }
+    return;
+}
+
+#endif
+
+// prepend()
+// Insert new element into L. If L is non-empty,
+// insertion takes place before front element.
+// Pre: List!= NULL
+void prepend(List L, int data) {
+    FAIL_IF(L == NULL, "List Error: calling prepend() on NULL List reference\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    hashPrepend(L, data);
+    if (L->front == NULL || L->front->count == BLOCK_CAP) {
+        insertBlock(L, NULL, newBlock(L->pool), 0);
+        STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+    }
+    insertAt(L, L->front, 0, data, 0);
+    if (L->cursor_index != -1) {
+        L->cursor_index++;
+    }
+    return;
+}
+
+// append()
+// Insert new element into L. If L is non-empty,
+// insertion takes place after back element.
+// Pre: List != NULL
+void append(List L, int data) {
+    FAIL_IF(L == NULL, "List Error: calling append() on NULL List reference\n");
+    STAT_TIME(LIST_OP_INSERT);
+    hashAppend(L, data);
+    if (L->pack != NULL) {
+        packAppend(L->pack, data);
+        L->length++;
+        L->version++;
+        return;
+    }
+    materialize(L);
+    if (L->back == NULL || L->back->count == BLOCK_CAP) {
+        insertBlock(L, L->back, newBlock(L->pool), L->length);
+        STAT_ADD(L, STAT_NODES_ALLOCATED, 1);
+    }
+    if (L->skip != NULL) {
+        skipResize(L, L->length - L->back->count, L->back, 1);
+    }
+    L->back->data[L->back->count++] = data;
+    L->length++;
+    return;
+}
+
+// appendArray()
+// Inserts the n elements of data into L, in order, after the back element.
+// The elements are copied a whole block at a time.
+// Pre: List != NULL, data != NULL if n > 0, length() + n <= INT_MAX
+void appendArray(List L, const int* data, size_t n) {
+    FAIL_IF(L == NULL, "List Error: calling appendArray() on NULL List reference\n");
+    FAIL_IF(data == NULL && n > 0, "List Error: calling appendArray() on NULL array\n");
+    FAIL_IF(n > (size_t)(INT_MAX - L->length), "List Error: calling appendArray() with too many elements\n");
+    STAT_TIME(LIST_OP_INSERT);
+    for (size_t i = 0; i < n; i++) {
+        hashAppend(L, data[i]);
+    }
+    if (L->pack != NULL) {
+        for (size_t i = 0; i < n; i++) {
+            packAppend(L->pack, data[i]);
+        }
+        L->length += (int)n;
+        L->version++;
+        return;
+    }
+    materialize(L);
+    appendData(L, data, (int)n);
+    return;
+}
+
+// Insert new element before cursor.
+// Pre: length()>0, index()>=0, List != NULL
+void insertBefore(List L, int data) {
+    FAIL_IF(L == NULL, "List Error: calling insertBefore() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling insertBefore() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling insertBefore() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    if (L->cursor_index == 0) {
+        hashPrepend(L, data);
+    }
+    else {
+        L->hash_power = 0;
+    }
+    insertAt(L, L->cursor, L->cursor_offset, data, L->cursor_index - L->cursor_offset);
+    L->cursor_index++;
+    return;
+}
+
+// insertAfter()
+// Insert new element after cursor.
+// Pre: length()>0, index()>=0, List != NULL
+void insertAfter(List L, int data) {
+    FAIL_IF(L == NULL, "List Error: calling insertAfter() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling insertAfter() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling insertAfter() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    if (L->cursor_index == L->length - 1) {
+        hashAppend(L, data);
+    }
+    else {
+        L->hash_power = 0;
+    }
+    insertAt(L, L->cursor, L->cursor_offset + 1, data, L->cursor_index - L->cursor_offset);
+    return;
+}
+
+// deleteFront()
+// Delete the front element. Pre: length()>0, List != NULL
+void deleteFront(List L) {
+    FAIL_IF(L == NULL, "List Error: calling deleteFront() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling deleteFront() on an empty List\n");
+    STAT_TIME(LIST_OP_DELETE);
+    materialize(L);
+    hashDeleteFront(L, L->front->data[0]);
+    removeAt(L, L->front, 0, 0);
+    if (L->cursor_index > 0) {
+        L->cursor_index--;
+    }
+    return;
+}
+
+// deleteBack()
+// Delete the back element. Pre: length()>0, List != NULL
+void deleteBack(List L) {
+    FAIL_IF(L == NULL, "List Error: calling deleteBack() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling deleteBack() on an empty List\n");
+    STAT_TIME(LIST_OP_DELETE);
+    materialize(L);
+    hashDeleteBack(L, L->back->data[L->back->count - 1]);
+    removeAt(L, L->back, L->back->count - 1, L->length - L->back->count);
+    return;
+}
+
+// delete()
+// Delete cursor element, making cursor undefined.
+// Pre: length()>0, index()>=0, List != NULL
+void delete(List L) {
+    FAIL_IF(L == NULL, "List Error: calling delete() on NULL List reference\n");
+    FAIL_IF(L->length == 0, "List Error: calling delete() on an empty List\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling delete() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_DELETE);
+    materialize(L);
+    int x = L->cursor->data[L->cursor_offset];
+    if (L->cursor_index == 0) {
+        hashDeleteFront(L, x);
+    }
+    else if (L->cursor_index == L->length - 1) {
+        hashDeleteBack(L, x);
+    }
+    else {
+        L->hash_power = 0;
+    }
+    removeAt(L, L->cursor, L->cursor_offset, L->cursor_index - L->cursor_offset);
+    return;
+}
+
+// mergeRuns()
+// Merges the sorted ranges a[lo..mid) and a[mid..hi) into out[lo..hi).
+// On ties elements of the first range come first.
+void mergeRuns(const int* a, int* out, int lo, int mid, int hi,
+               int (*cmp)(int, int, void*), void* ctx) {
+    int i = lo, j = mid, k = lo;
+    while (i < mid && j < hi) {
+        if (cmp(a[i], a[j], ctx) <= 0) {
+            out[k++] = a[i++];
+        }
+        else {
+            out[k++] = a[j++];
+        }
+    }
+    memcpy(out + k, a + i, (mid - i) * sizeof(int));
+    memcpy(out + k + mid - i, a + j, (hi - j) * sizeof(int));
+}
+
+// sortList()
+// Sorts L into non-decreasing order under cmp, which returns a negative,
+// zero or positive value as its first argument is less than, equal to or
+// greater than its second; ctx is passed through to every call. The sort
+// is a stable natural merge sort that reuses the existing storage of L, so
+// already ordered runs cost one pass. The cursor becomes undefined.
+// Pre: List != NULL, cmp != NULL
+void sortList(List L, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling sortList() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling sortList() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_SORT);
+    materialize(L);
+    int n = L->length;
+    int* a = malloc((n + 1) * sizeof(int));
+    int* b = malloc((n + 1) * sizeof(int));
+    int* run = malloc((n + 1) * sizeof(int));
+    int runs = 0;
+    int i = 0;
+    for (Block B = L->front; B != NULL; B = B->next) {
+        memcpy(a + i, B->data, B->count * sizeof(int));
+        i += B->count;
+    }
+    // split a into maximal runs, reversing strictly descending ones
+    for (i = 0; i < n; ) {
+        int j = i + 1;
+        if (j < n && cmp(a[i], a[j], ctx) > 0) {
+            while (j < n && cmp(a[j - 1], a[j], ctx) > 0) j++;
+            for (int lo = i, hi = j - 1; lo < hi; lo++, hi--) {
+                int t = a[lo];
+                a[lo] = a[hi];
+                a[hi] = t;
+            }
+        }
+        else {
+            while (j < n && cmp(a[j - 1], a[j], ctx) <= 0) j++;
+        }
+        run[runs++] = i;
+        i = j;
+    }
+    run[runs] = n;
+    // merge neighbouring runs pairwise until one is left
+    while (runs > 1) {
+        int r;
+        for (r = 0; r + 1 < runs; r += 2) {
+            mergeRuns(a, b, run[r], run[r + 1], run[r + 2], cmp, ctx);
+            run[r / 2] = run[r];
+        }
+        if (r < runs) {
+            memcpy(b + run[r], a + run[r], (run[r + 1] - run[r]) * sizeof(int));
+            run[r / 2] = run[r];
+        }
+        runs = (runs + 1) / 2;
+        run[runs] = n;
+        int* t = a;
+        a = b;
+        b = t;
+    }
+    i = 0;
+    for (Block B = L->front; B != NULL; B = B->next) {
+        memcpy(B->data, a + i, B->count * sizeof(int));
+        i += B->count;
+    }
+    free(a);
+    free(b);
+    free(run);
+    L->cursor = NULL;
+    L->cursor_index = -1;
+    L->hash_power = 0;
+    return;
+}
+
+// lowerBound()
+// Sets the cursor under the first element of L not less than x under cmp,
+// and returns its index, or makes the cursor undefined and returns length()
+// if every element is less. L must be sorted under cmp.
+// Pre: List != NULL, cmp != NULL
+int lowerBound(List L, int x, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling lowerBound() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling lowerBound() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_SEEK);
+    int p;
+    if (L->pack != NULL) {
+        p = packBound(L, x, 0, cmp, ctx);
+    }
+    else {
+        Block B;
+        int o;
+        p = seekBound(L, x, 0, cmp, ctx, &B, &o);
+        L->cursor = B;
+        L->cursor_offset = o;
+    }
+    L->cursor_index = (p < L->length ? p : -1);
+    return p;
+}
+
+// findSorted()
+// Returns the index of the first element of L equal to x under cmp, with
+// the cursor under it, or -1 with the cursor as lowerBound() leaves it.
+// L must be sorted under cmp.
+// Pre: List != NULL, cmp != NULL
+int findSorted(List L, int x, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling findSorted() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling findSorted() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_SEEK);
+    int p = lowerBound(L, x, cmp, ctx);
+    if (p < L->length && cmp(get(L), x, ctx) == 0) {
+        return p;
+    }
+    return -1;
+}
+
+// insertSorted()
+// Inserts x into L after every element not greater than it under cmp, and
+// sets the cursor under it. L must be sorted under cmp.
+// Pre: List != NULL, cmp != NULL
+void insertSorted(List L, int x, int (*cmp)(int, int, void*), void* ctx) {
+    FAIL_IF(L == NULL, "List Error: calling insertSorted() on NULL List reference\n");
+    FAIL_IF(cmp == NULL, "List Error: calling insertSorted() with NULL comparison function\n");
+    STAT_TIME(LIST_OP_INSERT);
+    materialize(L);
+    Block B;
+    int o;
+    int p = seekBound(L, x, 1, cmp, ctx, &B, &o);
+    if (p == L->length) {
+        append(L, x);
+        moveBack(L);
+        return;
+    }
+    L->cursor = B;
+    L->cursor_offset = o;
+    L->cursor_index = p;
+    insertBefore(L, x);
+    movePrev(L);
+    return;
+}
+
+// spliceList()
+// Moves every element of S to the back of L, in order, leaving S empty.
+// Blocks are relinked rather than copied, so this takes O(1) time unless
+// L has a positional index, which is dropped, or the pools of both Lists
+// are each shared with other Lists, in which case the elements are copied.
+// The cursor of L is unchanged.
+// Pre: L != NULL, S != NULL, L != S
+void spliceList(List L, List S) {
+    FAIL_IF(L == NULL || S == NULL, "List Error: calling spliceList() on NULL List reference\n");
+    FAIL_IF(L == S, "List Error: calling spliceList() on the same List twice\n");
+    STAT_TIME(LIST_OP_SPLICE);
+    if (S->length == 0) {
+        return;
+    }
+    materialize(L);
+    hashJoin(L, S);
+    Block first, last;
+    int n = takeBlocks(L, S, &first, &last);
+    freeSkip(L);
+    first->prev = L->back;
+    if (L->back == NULL) {
+        L->front = first;
+    }
+    else {
+        L->back->next = first;
+    }
+    L->back = last;
+    L->length += n;
+    return;
+}
+
+// spliceAtCursor()
+// Moves every element of S into L, in order, directly before the cursor
+// element, leaving S empty. The cursor stays on the same element. Costs
+// as spliceList() does, plus splitting the cursor block.
+// Pre: L != NULL, S != NULL, L != S, length()>0, index()>=0
+void spliceAtCursor(List L, List S) {
+    FAIL_IF(L == NULL || S == NULL, "List Error: calling spliceAtCursor() on NULL List reference\n");
+    FAIL_IF(L == S, "List Error: calling spliceAtCursor() on the same List twice\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling spliceAtCursor() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_SPLICE);
+    if (S->length == 0) {
+        return;
+    }
+    materialize(L);
+    Block first, last;
+    int n = takeBlocks(L, S, &first, &last);
+    freeSkip(L);
+    Block C = cutAtCursor(L);
+    first->prev = C->prev;
+    if (C->prev == NULL) {
+        L->front = first;
+    }
+    else {
+        C->prev->next = first;
+    }
+    last->next = C;
+    C->prev = last;
+    L->length += n;
+    L->cursor_index += n;
+    L->hash_power = 0;
+    return;
+}
+
+// splitAt()
+// Cuts L in two before the cursor element. Returns a new List holding the
+// cursor element and every element after it, and leaves the ones before it
+// in L. Both Lists share L's storage, and the cursor is undefined in both.
+// Takes O(1) time unless L has a positional index, which is dropped.
+// Pre: List != NULL, length()>0, index()>=0
+List splitAt(List L) {
+    FAIL_IF(L == NULL, "List Error: calling splitAt() on NULL List reference\n");
+    FAIL_IF(!(index(L) >= 0), "List Error: calling splitAt() on an undefined cursor element\n");
+    STAT_TIME(LIST_OP_SPLICE);
+    materialize(L);
+    List R = newList();
+    releasePool(&R->pool);
+    R->pool = L->pool;
+    holdRef(&R->pool->refs);
+    freeSkip(L);
+    Block B = cutAtCursor(L);
+    R->front = B;
+    R->back = L->back;
+    R->length = L->length - L->cursor_index;
+    L->back = B->prev;
+    if (L->back == NULL) {
+        L->front = NULL;
+    }
+    else {
+        L->back->next = NULL;
+    }
+    B->prev = NULL;
+    L->length = L->cursor_index;
+    L->cursor = NULL;
+    L->cursor_index = -1;
+    L->hash_power = 0;
+    R->hash_power = 0;
+    return R;
+}
+
+// Other operations -----------------------------------------------------------
+
+// Lists of at most PRINT_BATCH elements are printed with one fwrite() of
+// a stack buffer, as a Writer would cost more than it saves; longer ones
+// go through a Writer, a block at a time.
+#define PRINT_BATCH 64
+
+// printList()
+// Prints to the file pointed to by out, a
+// string representation of L consisting
+// of a space separated sequence of integers,
+// with front on left. Returns 0, or -1 with errno
+// set if writing fails.
+// Pre: file != NULL, List != NULL
+int printList(FILE* out, List L) {
+    FAIL_IF(L == NULL, "List Error: calling printList() on NULL List reference\n");
+    FAIL_IF(out == NULL, "File Error: calling printList() on NULL file pointer");
+    STAT_TIME(LIST_OP_IO);
+    if (L->length <= PRINT_BATCH) {
+        int data[PRINT_BATCH];
+        char text[PRINT_BATCH * WRITER_INT_CHARS];
+        toArray(L, data, L->length);
+        size_t n = formatInts(text, data, L->length);
+        return (fwrite(text, 1, n, out) == n ? 0 : -1);
+    }
+    Writer W = newWriter(out);
+    if (L->pack != NULL) {
+        printPack(W, L->pack);
+    }
+    for (Block B = L->front; B != NULL; B = B->next) {
+        writeInts(W, B->data, B->count);
+    }
+    return freeWriter(&W);
+}
+
+// saveList()
+// Writes L to out in binary, to be read back by loadList() or mapList().
+// Returns 0, or -1 with errno set if writing fails.
+// Pre: List != NULL, out != NULL
+int saveList(List L, FILE* out) {
+    FAIL_IF(L == NULL, "List Error: calling saveList() on NULL List reference\n");
+    FAIL_IF(out == NULL, "File Error: calling saveList() on NULL file pointer\n");
+    STAT_TIME(LIST_OP_IO);
+    int* data = malloc((L->length > 0 ? L->length : 1) * sizeof(int));
+    toArray(L, data, L->length);
+    int result = writeListFile(out, data, L->length);
+    free(data);
+    return result;
+}
+
+// copyList()
+// Returns a new List representing the same integer
+// sequence as L. The cursor in the new list is undefined,
+// regardless of the state of the cursor in L. The state
+// of L is unchanged. Takes O(1) time: the copy shares
+// the blocks of L until either List is changed. The copy
+// of a compact List is compact, and copies its blocks.
+// Pre: List!= NULL
+List copyList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling copyList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_COPY);
+    List Y = newList();
+    Y->hash = L->hash;
+    Y->hash_power = L->hash_power;
+    STAT_ADD(L, STAT_COPIES, 1);
+    if (L->pack != NULL) {
+        Y->pack = copyPack(L->pack);
+        STAT_ADD(L, STAT_BYTES_COPIED, packBytes(Y->pack));
+        Y->length = L->length;
+        return Y;
+    }
+    if (L->length == 0) {
+        return Y;
+    }
+    if (L->share == NULL) {
+        L->share = malloc(sizeof(ShareObj));
+        L->share->refs = 1;
+    }
+    holdRef(&L->share->refs);
+    Y->share = L->share;
+    releasePool(&Y->pool);
+    Y->pool = L->pool;
+    holdRef(&Y->pool->refs);
+    Y->front = L->front;
+    Y->back = L->back;
+    Y->length = L->length;
+    return Y;
+}
+
+// concatList()
+// Returns a new List which is the concatenation of
+// A and B. The cursor in the new List is undefined,
+// regardless of the states of the cursors in A and B.
+// The states of A and B are unchanged.
+List concatList(List A, List B) {
+    FAIL_IF(A == NULL || B == NULL, "List Error: calling copyList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_COPY);
+    List Y = newList();
+    STAT_ADD(A, STAT_CONCATS, 1);
+    STAT_ADD(B, STAT_CONCATS, 1);
+    appendCopy(Y, A);
+    appendCopy(Y, B);
+    return Y;
+}
+
+// packList()
+// Switches L to compact mode, see newPackedList(), keeping its elements and
+// cursor position.
+// Pre: List != NULL
+void packList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling packList() on NULL List reference\n");
+    STAT_TIME(LIST_OP_COPY);
+    if (L->pack != NULL) {
+        return;
+    }
+    Pack P = newPack();
+    for (Block B = L->front; B != NULL; B = B->next) {
+        for (int i = 0; i < B->count; i++) {
+            packAppend(P, B->data[i]);
+        }
+    }
+    STAT_ADD(L, STAT_BYTES_COPIED, L->length * sizeof(int));
+    int n = L->length;
+    int i = index(L);
+    unsigned long long h = L->hash;
+    unsigned long long p = L->hash_power;
+    clear(L);
+    L->pack = P;
+    L->length = n;
+    L->cursor_index = i;
+    L->cursor_offset = 0;
+    L->hash = h;
+    L->hash_power = p;
+    return;
+}
+
+// listBytes()
+// Returns the number of bytes of heap memory holding L and its elements.
+// Storage shared with copies is counted in full.
+// Pre: List != NULL
+size_t listBytes(List L) {
+    FAIL_IF(L == NULL, "List Error: calling listBytes() on NULL List reference\n");
+    if (L->pack != NULL) {
+        return sizeof(ListObj) + sizeof(LockObj) + STAT_BYTES + packBytes(L->pack);
+    }
+    return sizeof(ListObj) + sizeof(LockObj) + STAT_BYTES + (size_t)countBlocks(L) * sizeof(BlockObj);
+}
+
+// Iterators ------------------------------------------------------------------
+
+// newListIter()
+// Returns reference to new ListIter over L, with its position undefined.
+// Pre: List != NULL
+ListIter newListIter(List L) {
+    FAIL_IF(L == NULL, "List Error: calling newListIter() on NULL List reference\n");
+    ListIter I = malloc(sizeof(ListIterObj));
+    I->list = L;
+    I->block = NULL;
+    I->offset = 0;
+    I->index = -1;
+    I->version = L->version;
+    I->decoded = -1;
+    I->buffer = NULL;
+    return(I);
+}
+
+// freeListIter()
+// Frees all heap memory associated with ListIter *pI, and sets *pI to NULL.
+// Pre: ListIter != NULL
+void freeListIter(ListIter* pI) {
+    FAIL_IF(pI == NULL || *pI == NULL, "List Error: calling freeListIter() on NULL ListIter reference\n");
+    free((*pI)->buffer);
+    free(*pI);
+    *pI = NULL;
+}
+
+// iterFront()
+// Begins a new traversal of the List of I: if it is non-empty, sets I on
+// its front element, otherwise makes the position of I undefined.
+// Pre: ListIter != NULL
+void iterFront(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterFront() on NULL ListIter reference\n");
+    List L = I->list;
+    I->version = L->version;
+    I->index = (L->length > 0 ? 0 : -1);
+    I->block = L->front;
+    I->offset = 0;
+}
+
+// iterBack()
+// Begins a new traversal of the List of I: if it is non-empty, sets I on
+// its back element, otherwise makes the position of I undefined.
+// Pre: ListIter != NULL
+void iterBack(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterBack() on NULL ListIter reference\n");
+    List L = I->list;
+    I->version = L->version;
+    I->index = L->length - 1;
+    I->block = L->back;
+    I->offset = (L->back != NULL ? L->back->count - 1 : 0);
+}
+
+// iterIndex()
+// Returns index of the element under I if defined, -1 otherwise.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+int iterIndex(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterIndex() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterIndex() on ListIter invalidated by a change to its List\n");
+    return I->index;
+}
+
+// iterGet()
+// Returns the element under I. The blocks of a compact List are decoded
+// into I, one at a time, so that the List itself is only read.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began,
+// iterIndex() >= 0
+int iterGet(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterGet() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterGet() on ListIter invalidated by a change to its List\n");
+    FAIL_IF(I->index < 0, "List Error: calling iterGet() on an undefined ListIter position\n");
+    if (I->list->pack != NULL) {
+        int b = I->index / PACK_BLOCK;
+        if (b != I->decoded) {
+            if (I->buffer == NULL) {
+                I->buffer = malloc(PACK_BLOCK * sizeof(int));
+            }
+            packBlock(I->list->pack, b, I->buffer);
+            I->decoded = b;
+        }
+        return I->buffer[I->index % PACK_BLOCK];
+    }
+    return I->block->data[I->offset];
+}
+
+// iterPrev()
+// Moves I one step toward the front, as movePrev() moves the cursor.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+void iterPrev(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterPrev() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterPrev() on ListIter invalidated by a change to its List\n");
+    if (I->index < 0) {
+        return;
+    }
+    if (I->index-- == 0 || I->list->pack != NULL) {
+        I->block = NULL;
+    }
+    else if (I->offset-- == 0) {
+        I->block = I->block->prev;
+        I->offset = I->block->count - 1;
+    }
+}
+
+// iterNext()
+// Moves I one step toward the back, as moveNext() moves the cursor.
+// Pre: ListIter != NULL, List of I unchanged since the traversal began
+void iterNext(ListIter I) {
+    FAIL_IF(I == NULL, "List Error: calling iterNext() on NULL ListIter reference\n");
+    FAIL_IF(I->version != I->list->version, "List Error: calling iterNext() on ListIter invalidated by a change to its List\n");
+    if (I->index < 0) {
+        return;
+    }
+    if (++I->index == I->list->length) {
+        I->index = -1;
+        I->block = NULL;
+    }
+    else if (I->list->pack == NULL && ++I->offset == I->block->count) {
+        I->block = I->block->next;
+        I->offset = 0;
+    }
+}
+
+// Locking --------------------------------------------------------------------
+
+// readLockList()
+// Waits until no thread holds or awaits the write lock of L, then takes a
+// read lock.
+// Pre: List != NULL
+void readLockList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling readLockList() on NULL List reference\n");
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_lock(&K->mutex);
+    while (K->writers > 0) {
+        pthread_cond_wait(&K->readable, &K->mutex);
+    }
+    K->readers++;
+    pthread_mutex_unlock(&K->mutex);
+}
+
+// writeLockList()
+// Waits until no thread holds any lock of L, then takes the write lock.
+// Pre: List != NULL
+void writeLockList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling writeLockList() on NULL List reference\n");
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_lock(&K->mutex);
+    K->writers++;
+    while (K->readers > 0 || K->writing) {
+        pthread_cond_wait(&K->writable, &K->mutex);
+    }
+    K->writing = 1;
+    pthread_mutex_unlock(&K->mutex);
+}
+
+// unlockList()
+// Releases the read or write lock of L held by this thread, waking the
+// next writer if there is one, else every waiting reader.
+// Pre: List != NULL, lock of L held by this thread
+void unlockList(List L) {
+    FAIL_IF(L == NULL, "List Error: calling unlockList() on NULL List reference\n");
+    LockObj* K = LIST_LOCK(L);
+    pthread_mutex_lock(&K->mutex);
+    if (K->writing) {
+        K->writing = 0;
+        K->writers--;
+    }
+    else {
+        K->readers--;
+    }
+    if (K->writers > 0) {
+        if (K->readers == 0) {
+            pthread_cond_signal(&K->writable);
+        }
+    }
+    else {
+        pthread_cond_broadcast(&K->readable);
+    }
+    pthread_mutex_unlock(&K->mutex);
+}
+
+// Statistics -----------------------------------------------------------------
+
+#ifdef LIST_STATS
+
+// listStats()
+// Fills *out with the counters of L, or with the totals of every List if L
+// is NULL.
+// Pre: out != NULL
+void listStats(List L, ListStats* out) {
+    FAIL_IF(out == NULL, "List Error: calling listStats() on NULL ListStats reference\n");
+    statRead(L != NULL ? LIST_COUNTS(L) : NULL, out);
+}
+
+#endif
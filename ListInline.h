@@ -0,0 +1,384 @@
+/*
+ * File:   ListInline.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ * Layout of the List ADT, shared by List.c and ListBlock.c. Clients never
+ * include this file themselves: List.h does so when LIST_UNCHECKED is
+ * defined, so that the hot accessors and cursor moves below inline into
+ * client loops. LIST_BLOCK selects the layout of ListBlock.c; a client
+ * built with LIST_UNCHECKED must be built with LIST_BLOCK (and the same
+ * LIST_BLOCK_BYTES) exactly when it is linked with ListBlock.c. Likewise
+ * LIST_INDEX selects the array-backed nodes of List.c, and must match the
+ * build of List.c.
+ */
+
+#ifndef LIST_INLINE_H_INCLUDE_
+#define LIST_INLINE_H_INCLUDE_
+
+#include<assert.h>
+#include<stdint.h>
+
+// Private types --------------------------------------------------------------
+
+struct PoolObj;
+struct TowerObj;
+struct ShareObj;
+struct PackObj;
+
+#ifdef LIST_BLOCK
+
+// Size in bytes of one block, links and count included.
+#ifndef LIST_BLOCK_BYTES
+#define LIST_BLOCK_BYTES 128
+#endif
+
+// Number of elements a full block holds.
+#define BLOCK_CAP ((int)((LIST_BLOCK_BYTES - 2 * sizeof(void*) - sizeof(int)) / sizeof(int)))
+
+// private BlockObj type
+typedef struct BlockObj {
+    struct BlockObj* next;
+    struct BlockObj* prev;
+    int count;
+    int data[BLOCK_CAP];
+} BlockObj;
+
+// private ListObj type
+typedef struct ListObj {
+    BlockObj* front;
+    BlockObj* back;
+    BlockObj* cursor;   // block holding the cursor element
+    int cursor_offset;  // position of the cursor element within its block
+    int length;
+    int cursor_index;
+    struct PoolObj* pool;
+    struct TowerObj* skip;  // head of the positional index, NULL until needed
+    unsigned skip_seed;
+    struct ShareObj* share; // set while the blocks may be shared with snapshots
+    struct PackObj* pack;   // encoded elements of a compact List, else NULL
+    unsigned version;       // bumped by every change, see ListIter
+    unsigned long long hash;        // fingerprint of the elements, see listHash()
+    unsigned long long hash_power;  // HASH_BASE^length, 0 while hash is stale
+} ListObj;
+
+#elif defined(LIST_INDEX)
+
+// private NodeObj type
+// A node of a LIST_INDEX build. The nodes of a pool live in one array and
+// are linked by their positions in it, so that a node takes 12 bytes where
+// two pointers would make it 24. Position 0 is never handed out and stands
+// for no node.
+typedef struct NodeObj {
+    int data;
+    uint32_t next;
+    uint32_t prev;
+} NodeObj;
+
+// private PoolObj type
+// The node array of a LIST_INDEX build and its free list. The array grows
+// by half whenever it is full, which may move it, so nodes are only ever
+// reached through it.
+typedef struct PoolObj {
+    NodeObj* nodes;
+    uint32_t free;  // recycled nodes, linked through next
+    uint32_t used;  // positions handed out, 0 included
+    uint32_t size;  // capacity of nodes
+    int refs;       // number of Lists drawing nodes from the pool
+} PoolObj;
+
+// private ListObj type
+typedef struct ListObj {
+    uint32_t front;
+    uint32_t back;
+    uint32_t cursor;
+    int length;
+    int cursor_index;
+    struct PoolObj* pool;
+    struct TowerObj* skip;  // head of the positional index, NULL until needed
+    unsigned skip_seed;
+    struct ShareObj* share; // set while the nodes may be shared with snapshots
+    struct PackObj* pack;   // encoded elements of a compact List, else NULL
+    unsigned version;       // bumped by every change, see ListIter
+    unsigned long long hash;        // fingerprint of the elements, see listHash()
+    unsigned long long hash_power;  // HASH_BASE^length, 0 while hash is stale
+} ListObj;
+
+// NODE_NIL, POOL_AT(), NODE_AT()
+// No node, and the node N of pool P or of the pool of List L.
+#define NODE_NIL 0
+#define POOL_AT(P, N) ((P)->nodes[N])
+#define NODE_AT(L, N) POOL_AT((L)->pool, N)
+
+#else
+
+// private NodeObj type
+typedef struct NodeObj {
+    int data;
+    struct NodeObj* next;
+    struct NodeObj* prev;
+} NodeObj;
+
+// private ListObj type
+typedef struct ListObj {
+    NodeObj* front;
+    NodeObj* back;
+    NodeObj* cursor;
+    int length;
+    int cursor_index;
+    struct PoolObj* pool;
+    struct TowerObj* skip;  // head of the positional index, NULL until needed
+    unsigned skip_seed;
+    struct ShareObj* share; // set while the nodes may be shared with snapshots
+    struct PackObj* pack;   // encoded elements of a compact List, else NULL
+    unsigned version;       // bumped by every change, see ListIter
+    unsigned long long hash;        // fingerprint of the elements, see listHash()
+    unsigned long long hash_power;  // HASH_BASE^length, 0 while hash is stale
+} ListObj;
+
+// NODE_NIL, POOL_AT(), NODE_AT()
+// No node, and the node N of pool P or of the pool of List L.
+#define NODE_NIL NULL
+#define POOL_AT(P, N) (*(N))
+#define NODE_AT(L, N) (*(N))
+
+#endif
+
+#ifdef LIST_UNCHECKED
+
+// Inline functions -----------------------------------------------------------
+
+// These replace the out of line functions of the same names. Preconditions
+// are only assert()ed, so they vanish under NDEBUG; breaking one is
+// undefined behavior instead of an error message. A compact List has no
+// nodes or blocks, only cursor_index, and reads its elements with packGet().
+
+int packGet(struct PackObj* P, int i);
+
+// length()
+// Returns the number of elements in L.
+// Pre: List != NULL
+static inline int length(List L) {
+    assert(L != NULL);
+    return L->length;
+}
+
+#ifdef LIST_BLOCK
+
+// index()
+// Returns index of cursor element if defined, -1 otherwise.
+// Pre: List != NULL
+static inline int index(List L) {
+    assert(L != NULL);
+    return (L->cursor == NULL && L->pack == NULL ? -1 : L->cursor_index);
+}
+
+// front()
+// Returns front element of L. Pre: length()>0, List != NULL
+static inline int front(List L) {
+    assert(L != NULL && L->length > 0);
+    if (L->pack != NULL) {
+        return packGet(L->pack, 0);
+    }
+    return L->front->data[0];
+}
+
+// back()
+// Returns back element of L. Pre: length()>0, List != NULL
+static inline int back(List L) {
+    assert(L != NULL && L->length > 0);
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->length - 1);
+    }
+    return L->back->data[L->back->count - 1];
+}
+
+// get()
+// Returns cursor element of L.
+// Pre: List!= NULL, length() > 0, index() >= 0
+static inline int get(List L) {
+    assert(L != NULL && (L->cursor != NULL || (L->pack != NULL && L->cursor_index >= 0)));
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->cursor_index);
+    }
+    return L->cursor->data[L->cursor_offset];
+}
+
+// moveFront()
+// If L is non-empty, sets cursor under the front element,
+// otherwise does nothing.
+// Pre: List!= NULL
+static inline void moveFront(List L) {
+    assert(L != NULL);
+    if (L->length > 0) {
+        L->cursor_index = 0;
+        L->cursor = L->front;
+        L->cursor_offset = 0;
+    }
+}
+
+// moveBack()
+// If L is non-empty, sets cursor under the back element,
+// otherwise does nothing.
+// Pre: List!= NULL
+static inline void moveBack(List L) {
+    assert(L != NULL);
+    if (L->length > 0) {
+        L->cursor_index = L->length - 1;
+        L->cursor = L->back;
+        L->cursor_offset = (L->pack != NULL ? 0 : L->back->count - 1);
+    }
+}
+
+// movePrev()
+// Moves the cursor one step toward the front of L, making it undefined
+// if it was at the front. Does nothing if the cursor is undefined.
+// Pre: List!= NULL
+static inline void movePrev(List L) {
+    assert(L != NULL);
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0) {
+            L->cursor_index--;
+        }
+        return;
+    }
+    if (L->cursor == NULL) {
+        return;
+    }
+    if (L->cursor_index-- == 0) {
+        L->cursor = NULL;
+    }
+    else if (L->cursor_offset-- == 0) {
+        L->cursor = L->cursor->prev;
+        L->cursor_offset = L->cursor->count - 1;
+    }
+}
+
+// moveNext()
+// Moves the cursor one step toward the back of L, making it undefined
+// if it was at the back. Does nothing if the cursor is undefined.
+// Pre: List != NULL
+static inline void moveNext(List L) {
+    assert(L != NULL);
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0 && ++L->cursor_index == L->length) {
+            L->cursor_index = -1;
+        }
+        return;
+    }
+    if (L->cursor == NULL) {
+        return;
+    }
+    if (++L->cursor_index == L->length) {
+        L->cursor_index = -1;
+        L->cursor = NULL;
+    }
+    else if (++L->cursor_offset == L->cursor->count) {
+        L->cursor = L->cursor->next;
+        L->cursor_offset = 0;
+    }
+}
+
+#else
+
+// index()
+// Returns index of cursor element if defined, -1 otherwise.
+// Pre: List != NULL
+static inline int index(List L) {
+    assert(L != NULL);
+    return (L->cursor == NODE_NIL && L->pack == NULL ? -1 : L->cursor_index);
+}
+
+// front()
+// Returns front element of L. Pre: length()>0, List != NULL
+static inline int front(List L) {
+    assert(L != NULL && L->length > 0);
+    if (L->pack != NULL) {
+        return packGet(L->pack, 0);
+    }
+    return NODE_AT(L, L->front).data;
+}
+
+// back()
+// Returns back element of L. Pre: length()>0, List != NULL
+static inline int back(List L) {
+    assert(L != NULL && L->length > 0);
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->length - 1);
+    }
+    return NODE_AT(L, L->back).data;
+}
+
+// get()
+// Returns cursor element of L.
+// Pre: List!= NULL, length() > 0, index() >= 0
+static inline int get(List L) {
+    assert(L != NULL && (L->cursor != NODE_NIL || (L->pack != NULL && L->cursor_index >= 0)));
+    if (L->pack != NULL) {
+        return packGet(L->pack, L->cursor_index);
+    }
+    return NODE_AT(L, L->cursor).data;
+}
+
+// moveFront()
+// If L is non-empty, sets cursor under the front element,
+// otherwise does nothing.
+// Pre: List!= NULL
+static inline void moveFront(List L) {
+    assert(L != NULL);
+    if (L->length > 0) {
+        L->cursor_index = 0;
+        L->cursor = L->front;
+    }
+}
+
+// moveBack()
+// If L is non-empty, sets cursor under the back element,
+// otherwise does nothing.
+// Pre: List!= NULL
+static inline void moveBack(List L) {
+    assert(L != NULL);
+    if (L->length > 0) {
+        L->cursor_index = L->length - 1;
+        L->cursor = L->back;
+    }
+}
+
+// movePrev()
+// Moves the cursor one step toward the front of L, making it undefined
+// if it was at the front. Does nothing if the cursor is undefined.
+// Pre: List!= NULL
+static inline void movePrev(List L) {
+    assert(L != NULL);
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0) {
+            L->cursor_index--;
+        }
+    }
+    else if (L->cursor != NODE_NIL) {
+        L->cursor_index--;
+        L->cursor = NODE_AT(L, L->cursor).prev;
+    }
+}
+
+// moveNext()
+// Moves the cursor one step toward the back of L, making it undefined
+// if it was at the back. Does nothing if the cursor is undefined.
+// Pre: List != NULL
+static inline void moveNext(List L) {
+    assert(L != NULL);
+    if (L->pack != NULL) {
+        if (L->cursor_index >= 0 && ++L->cursor_index == L->length) {
+            L->cursor_index = -1;
+        }
+    }
+    else if (L->cursor != NODE_NIL) {
+        L->cursor = NODE_AT(L, L->cursor).next;
+        L->cursor_index = (L->cursor == NODE_NIL ? -1 : L->cursor_index + 1);
+    }
+}
+
+#endif
+
+#endif
+
+#endif
@@ -0,0 +1,542 @@
+/*
+ * File:   ListPack.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<limits.h>
+#include<errno.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include "ListPack.h"
+#include "ListScan.h"
+
+// A varint carries 7 bits per byte, so a 32-bit difference takes at most
+// VARINT_MAX bytes and the unfinished last block at most TAIL_BYTES.
+#define VARINT_MAX 5
+#define TAIL_BYTES ((PACK_BLOCK - 1) * VARINT_MAX)
+
+// private PackBlockObj type
+typedef struct PackBlockObj {
+    int first;              // first element of the block
+    int size;               // bytes of data in use
+    unsigned char* data;    // varint differences of the other elements
+} PackBlockObj;
+
+// private MapObj type
+// A mapping of a List file, shared by the Packs reading it.
+typedef struct MapObj {
+    void* base;
+    size_t size;
+    int refs;
+} MapObj;
+
+// private PackObj type
+typedef struct PackObj {
+    PackBlockObj* blocks;
+    int capacity;           // blocks allocated
+    int count;              // elements held
+    int last;               // last element, base of the next difference
+    int decoded;            // block held in buffer, -1 if none
+    const int* array;       // elements of a mapped Pack, else NULL
+    MapObj* map;            // mapping that array points into
+    int buffer[PACK_BLOCK];
+} PackObj;
+
+// private FileHeader type
+// The 32 bytes in front of the elements of a List file. The elements are
+// native ints, so order holds FILE_ORDER as written by the saving machine
+// and width its sizeof(int); a file from a machine that differs in either
+// is rejected rather than misread.
+typedef struct FileHeader {
+    char magic[4];          // FILE_MAGIC
+    uint32_t version;       // FILE_VERSION
+    uint32_t order;
+    uint32_t width;
+    uint64_t length;        // elements that follow
+    uint64_t checksum;      // checksum() of the elements
+} FileHeader;
+
+#define FILE_MAGIC "LIST"
+#define FILE_VERSION 1
+#define FILE_ORDER 0x01020304u
+
+// blockLength()
+// Returns the number of elements in block b of P.
+static inline int blockLength(Pack P, int b) {
+    int n = P->count - b * PACK_BLOCK;
+    return (n < PACK_BLOCK ? n : PACK_BLOCK);
+}
+
+// blockCount()
+// Returns the number of blocks in use in P.
+static inline int blockCount(Pack P) {
+    return (P->count + PACK_BLOCK - 1) / PACK_BLOCK;
+}
+
+// decodeInto()
+// Writes the elements of block b of P into out.
+static void decodeInto(Pack P, int b, int* out) {
+    const PackBlockObj* B = &P->blocks[b];
+    const unsigned char* p = B->data;
+    int n = blockLength(P, b);
+    uint32_t x = (uint32_t)B->first;
+    out[0] = B->first;
+    for (int i = 1; i < n; i++) {
+        uint32_t z = 0;
+        int shift = 0;
+        unsigned char c;
+        do {
+            c = *p++;
+            z |= (uint32_t)(c & 0x7f) << shift;
+            shift += 7;
+        } while (c & 0x80);
+        x += (z >> 1) ^ (0u - (z & 1));
+        out[i] = (int)x;
+    }
+}
+
+// releaseMap()
+// Drops one reference to M, unmapping it with the last one.
+static void releaseMap(MapObj* M) {
+    if (--M->refs == 0) {
+        munmap(M->base, M->size);
+        free(M);
+    }
+}
+
+// checksum()
+// Returns the FNV-1a hash of the n ints of data, taken a word at a time.
+static uint64_t checksum(const int* data, size_t n) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint32_t)data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// checkHeader()
+// Returns true (1) iff H is the header of a List file of this machine with
+// at most INT_MAX elements.
+static int checkHeader(const FileHeader* H) {
+    return memcmp(H->magic, FILE_MAGIC, 4) == 0 && H->version == FILE_VERSION &&
+           H->order == FILE_ORDER && H->width == sizeof(int) && H->length <= INT_MAX;
+}
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newPack()
+// Returns reference to new empty Pack object.
+Pack newPack(void) {
+    Pack P = malloc(sizeof(PackObj));
+    P->blocks = NULL;
+    P->capacity = 0;
+    P->count = 0;
+    P->last = 0;
+    P->decoded = -1;
+    P->array = NULL;
+    P->map = NULL;
+    return P;
+}
+
+// mapPack()
+// Returns reference to new Pack object reading the elements of the List
+// file named path in place, from a read-only mapping, and sets *pLength to
+// their number. Only the header is checked. Returns NULL, with errno set,
+// if the file cannot be mapped, or EINVAL if it holds no List.
+Pack mapPack(const char* path, int* pLength) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0) {
+        if ((size_t)st.st_size < sizeof(FileHeader)) {
+            errno = EINVAL;
+        }
+        else {
+            base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+    }
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    const FileHeader* H = base;
+    if (!checkHeader(H) || H->length * sizeof(int) != st.st_size - sizeof(FileHeader)) {
+        munmap(base, st.st_size);
+        errno = EINVAL;
+        return NULL;
+    }
+    Pack P = newPack();
+    P->map = malloc(sizeof(MapObj));
+    P->map->base = base;
+    P->map->size = st.st_size;
+    P->map->refs = 1;
+    P->array = (const int*)(H + 1);
+    P->count = (int)H->length;
+    *pLength = P->count;
+    return P;
+}
+
+// freePack()
+// Frees all heap memory associated with Pack *pP, and sets *pP to NULL.
+void freePack(Pack* pP) {
+    if (pP != NULL && *pP != NULL) {
+        clearPack(*pP);
+        free(*pP);
+        *pP = NULL;
+    }
+}
+
+// copyPack()
+// Returns a new Pack holding the same elements as P, copied in their
+// encoded form, or sharing the mapping of a mapped P.
+Pack copyPack(Pack P) {
+    Pack Q = newPack();
+    if (P->array != NULL) {
+        Q->map = P->map;
+        Q->map->refs++;
+        Q->array = P->array;
+        Q->count = P->count;
+        return Q;
+    }
+    int blocks = blockCount(P);
+    if (blocks == 0) {
+        return Q;
+    }
+    Q->blocks = malloc(blocks * sizeof(PackBlockObj));
+    Q->capacity = blocks;
+    for (int b = 0; b < blocks; b++) {
+        // the last block keeps room to grow if it is not full yet
+        size_t room = (blockLength(P, b) < PACK_BLOCK ? TAIL_BYTES : (size_t)P->blocks[b].size);
+        Q->blocks[b] = P->blocks[b];
+        Q->blocks[b].data = malloc(room > 0 ? room : 1);
+        memcpy(Q->blocks[b].data, P->blocks[b].data, P->blocks[b].size);
+    }
+    Q->count = P->count;
+    Q->last = P->last;
+    return Q;
+}
+
+// Access functions -----------------------------------------------------------
+
+// packGet()
+// Returns element i of P, decoding its block unless it is the one held.
+// Pre: 0 <= i < number of elements in P
+int packGet(Pack P, int i) {
+    if (P->array != NULL) {
+        return P->array[i];
+    }
+    int b = i / PACK_BLOCK;
+    if (b != P->decoded) {
+        decodeInto(P, b, P->buffer);
+        P->decoded = b;
+    }
+    return P->buffer[i % PACK_BLOCK];
+}
+
+// packDecode()
+// Writes the first n elements of P into out, in order.
+// Pre: 0 <= n <= number of elements in P
+void packDecode(Pack P, int* out, int n) {
+    if (P->array != NULL) {
+        memcpy(out, P->array, n * sizeof(int));
+        return;
+    }
+    int b = 0;
+    for (; (b + 1) * PACK_BLOCK <= n; b++) {
+        decodeInto(P, b, out + b * PACK_BLOCK);
+    }
+    for (int i = b * PACK_BLOCK; i < n; i++) {
+        out[i] = packGet(P, i);
+    }
+}
+
+// packBlock()
+// Writes the elements of block b of P into out and returns their number,
+// leaving the block held by P alone.
+// Pre: 0 <= b < number of blocks in P
+int packBlock(Pack P, int b, int* out) {
+    int n = blockLength(P, b);
+    if (P->array != NULL) {
+        memcpy(out, P->array + b * PACK_BLOCK, n * sizeof(int));
+    }
+    else {
+        decodeInto(P, b, out);
+    }
+    return n;
+}
+
+// The aggregates below run the kernels of ListScan.c over the elements of
+// a mapped Pack in place, and over every other Pack a decoded block at a
+// time, without touching the block it holds.
+
+// packFind()
+// Returns the index of the first element of P equal to x, or -1.
+int packFind(Pack P, int x) {
+    if (P->array != NULL) {
+        return scanFind(P->array, P->count, x);
+    }
+    int out[PACK_BLOCK];
+    for (int b = 0; b < blockCount(P); b++) {
+        decodeInto(P, b, out);
+        int o = scanFind(out, blockLength(P, b), x);
+        if (o >= 0) {
+            return b * PACK_BLOCK + o;
+        }
+    }
+    return -1;
+}
+
+// packCount()
+// Returns the number of elements of P equal to x.
+int packCount(Pack P, int x) {
+    if (P->array != NULL) {
+        return scanCount(P->array, P->count, x);
+    }
+    int out[PACK_BLOCK];
+    int c = 0;
+    for (int b = 0; b < blockCount(P); b++) {
+        decodeInto(P, b, out);
+        c += scanCount(out, blockLength(P, b), x);
+    }
+    return c;
+}
+
+// packSum()
+// Returns the sum of the elements of P.
+long long packSum(Pack P) {
+    if (P->array != NULL) {
+        return scanSum(P->array, P->count);
+    }
+    int out[PACK_BLOCK];
+    long long s = 0;
+    for (int b = 0; b < blockCount(P); b++) {
+        decodeInto(P, b, out);
+        s += scanSum(out, blockLength(P, b));
+    }
+    return s;
+}
+
+// packMin()
+// Returns the least element of P.
+// Pre: P is not empty
+int packMin(Pack P) {
+    if (P->array != NULL) {
+        return scanMin(P->array, P->count);
+    }
+    int out[PACK_BLOCK];
+    int m = P->blocks[0].first;
+    for (int b = 0; b < blockCount(P); b++) {
+        decodeInto(P, b, out);
+        int k = scanMin(out, blockLength(P, b));
+        m = (k < m ? k : m);
+    }
+    return m;
+}
+
+// packMax()
+// Returns the greatest element of P.
+// Pre: P is not empty
+int packMax(Pack P) {
+    if (P->array != NULL) {
+        return scanMax(P->array, P->count);
+    }
+    int out[PACK_BLOCK];
+    int m = P->blocks[0].first;
+    for (int b = 0; b < blockCount(P); b++) {
+        decodeInto(P, b, out);
+        int k = scanMax(out, blockLength(P, b));
+        m = (k > m ? k : m);
+    }
+    return m;
+}
+
+// packEquals()
+// Returns true (1) iff A and B hold the same elements. The encoding of a
+// sequence is unique, so encoded blocks are compared without decoding them.
+int packEquals(Pack A, Pack B) {
+    if (A->count != B->count) {
+        return 0;
+    }
+    if (A->array != NULL || B->array != NULL) {
+        for (int i = 0; i < A->count; i++) {
+            if (packGet(A, i) != packGet(B, i)) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    for (int b = 0; b < blockCount(A); b++) {
+        const PackBlockObj* X = &A->blocks[b];
+        const PackBlockObj* Y = &B->blocks[b];
+        if (X->first != Y->first || X->size != Y->size ||
+            memcmp(X->data, Y->data, X->size) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// packBytes()
+// Returns the number of bytes of heap memory held by P. The pages of a
+// mapping are not counted.
+size_t packBytes(Pack P) {
+    if (P->array != NULL) {
+        return sizeof(PackObj) + sizeof(MapObj);
+    }
+    size_t bytes = sizeof(PackObj) + P->capacity * sizeof(PackBlockObj);
+    for (int b = 0; b < blockCount(P); b++) {
+        bytes += (blockLength(P, b) < PACK_BLOCK ? TAIL_BYTES : (size_t)P->blocks[b].size);
+    }
+    return bytes;
+}
+
+// Manipulation procedures ----------------------------------------------------
+
+// clearPack()
+// Resets P to its original empty state.
+void clearPack(Pack P) {
+    if (P->array != NULL) {
+        releaseMap(P->map);
+        P->map = NULL;
+        P->array = NULL;
+        P->count = 0;
+    }
+    for (int b = 0; b < blockCount(P); b++) {
+        free(P->blocks[b].data);
+    }
+    free(P->blocks);
+    P->blocks = NULL;
+    P->capacity = 0;
+    P->count = 0;
+    P->last = 0;
+    P->decoded = -1;
+}
+
+// packAppend()
+// Inserts data after the last element of P. A block is allocated with room
+// for the worst case and trimmed to its encoded size once it is full. A
+// mapped Pack is first encoded, and lets go of its mapping.
+void packAppend(Pack P, int data) {
+    if (P->array != NULL) {
+        const int* array = P->array;
+        int n = P->count;
+        MapObj* map = P->map;
+        P->map = NULL;
+        P->array = NULL;
+        P->count = 0;
+        for (int i = 0; i < n; i++) {
+            packAppend(P, array[i]);
+        }
+        releaseMap(map);
+    }
+    int b = P->count / PACK_BLOCK;
+    int o = P->count % PACK_BLOCK;
+    PackBlockObj* B;
+    if (o == 0) {
+        if (b == P->capacity) {
+            P->capacity = (P->capacity > 0 ? 2 * P->capacity : 4);
+            P->blocks = realloc(P->blocks, P->capacity * sizeof(PackBlockObj));
+        }
+        B = &P->blocks[b];
+        B->first = data;
+        B->size = 0;
+        B->data = malloc(TAIL_BYTES);
+    }
+    else {
+        B = &P->blocks[b];
+        uint32_t d = (uint32_t)data - (uint32_t)P->last;
+        uint32_t z = (d << 1) ^ (0u - (d >> 31));
+        while (z >= 0x80) {
+            B->data[B->size++] = (unsigned char)(z | 0x80);
+            z >>= 7;
+        }
+        B->data[B->size++] = (unsigned char)z;
+        if (o == PACK_BLOCK - 1) {
+            B->data = realloc(B->data, B->size);
+        }
+    }
+    if (P->decoded == b) {
+        P->buffer[o] = data;
+    }
+    P->last = data;
+    P->count++;
+}
+
+// Other operations -----------------------------------------------------------
+
+// printPack()
+// Writes the elements of P to W as printList() prints them.
+void printPack(Writer W, Pack P) {
+    if (P->array != NULL) {
+        writeInts(W, P->array, P->count);
+        return;
+    }
+    int buffer[PACK_BLOCK];
+    for (int b = 0; b < blockCount(P); b++) {
+        decodeInto(P, b, buffer);
+        writeInts(W, buffer, blockLength(P, b));
+    }
+}
+
+// writeListFile()
+// Writes the n ints of data to out as a List file. Returns 0, or -1 with
+// errno set if writing fails.
+int writeListFile(FILE* out, const int* data, int n) {
+    FileHeader H;
+    memcpy(H.magic, FILE_MAGIC, 4);
+    H.version = FILE_VERSION;
+    H.order = FILE_ORDER;
+    H.width = sizeof(int);
+    H.length = n;
+    H.checksum = checksum(data, n);
+    if (fwrite(&H, sizeof(H), 1, out) != 1 ||
+        fwrite(data, sizeof(int), n, out) != (size_t)n || fflush(out) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// readListFile()
+// Reads a List file from in. Returns a new array of its elements, to be
+// freed by the caller, and sets *pLength to their number. Returns NULL,
+// with errno set, if reading fails, or EINVAL if in holds no List or its
+// checksum does not match.
+int* readListFile(FILE* in, int* pLength) {
+    FileHeader H;
+    if (fread(&H, sizeof(H), 1, in) != 1) {
+        if (!ferror(in)) {
+            errno = EINVAL;
+        }
+        return NULL;
+    }
+    if (!checkHeader(&H)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    int n = (int)H.length;
+    int* data = malloc((n > 0 ? n : 1) * sizeof(int));
+    if (fread(data, sizeof(int), n, in) != (size_t)n || checksum(data, n) != H.checksum) {
+        if (!ferror(in)) {
+            errno = EINVAL;
+        }
+        free(data);
+        return NULL;
+    }
+    *pLength = n;
+    return data;
+}
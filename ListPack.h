@@ -0,0 +1,139 @@
+/*
+ * File:   ListPack.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ * Element storage of compact and mapped Lists, see newPackedList() and
+ * mapList(), and the List file format of saveList(), shared by List.c and
+ * ListBlock.c. Clients never include this file themselves.
+ */
+
+#ifndef LIST_PACK_H_INCLUDE_
+#define LIST_PACK_H_INCLUDE_
+
+#include<stdio.h>
+#include<stddef.h>
+#include "Writer.h"
+
+// Exported type --------------------------------------------------------------
+
+// A Pack holds a sequence of ints in blocks of PACK_BLOCK elements. Each
+// block keeps its first element whole and every later one as the zigzag
+// varint of its difference from the one before, so runs of close values
+// take a byte or two each. The block last looked into is kept decoded.
+// A mapped Pack instead reads the elements of a List file in place, until
+// an append encodes them.
+typedef struct PackObj* Pack;
+
+// Elements per block.
+#define PACK_BLOCK 128
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newPack()
+// Returns reference to new empty Pack object.
+Pack newPack(void);
+
+// freePack()
+// Frees all heap memory associated with Pack *pP, and sets *pP to NULL.
+void freePack(Pack* pP);
+
+// mapPack()
+// Returns reference to new Pack object reading the elements of the List
+// file named path in place, from a read-only mapping, and sets *pLength to
+// their number. Only the header is checked. Returns NULL, with errno set,
+// if the file cannot be mapped, or EINVAL if it holds no List.
+Pack mapPack(const char* path, int* pLength);
+
+// copyPack()
+// Returns a new Pack holding the same elements as P, copied in their
+// encoded form, or sharing the mapping of a mapped P.
+Pack copyPack(Pack P);
+
+// Access functions -----------------------------------------------------------
+
+// packGet()
+// Returns element i of P, decoding its block unless it is the one held.
+// Pre: 0 <= i < number of elements in P
+int packGet(Pack P, int i);
+
+// packDecode()
+// Writes the first n elements of P into out, in order.
+// Pre: 0 <= n <= number of elements in P
+void packDecode(Pack P, int* out, int n);
+
+// packBlock()
+// Writes the elements of block b of P into out and returns their number.
+// Unlike packGet(), it leaves the block held by P alone, so any number of
+// threads may call it on one Pack at once.
+// Pre: 0 <= b < number of blocks in P
+int packBlock(Pack P, int b, int* out);
+
+// packFind()
+// Returns the index of the first element of P equal to x, or -1.
+int packFind(Pack P, int x);
+
+// packCount()
+// Returns the number of elements of P equal to x.
+int packCount(Pack P, int x);
+
+// packSum()
+// Returns the sum of the elements of P.
+long long packSum(Pack P);
+
+// packMin()
+// Returns the least element of P.
+// Pre: P is not empty
+int packMin(Pack P);
+
+// packMax()
+// Returns the greatest element of P.
+// Pre: P is not empty
+int packMax(Pack P);
+
+// packEquals()
+// Returns true (1) iff A and B hold the same elements. The encoding of a
+// sequence is unique, so encoded blocks are compared without decoding them.
+int packEquals(Pack A, Pack B);
+
+// packBytes()
+// Returns the number of bytes of heap memory held by P. The pages of a
+// mapping are not counted.
+size_t packBytes(Pack P);
+
+// Manipulation procedures ----------------------------------------------------
+
+// clearPack()
+// Resets P to its original empty state.
+void clearPack(Pack P);
+
+// packAppend()
+// Inserts data after the last element of P. A mapped Pack is first
+// encoded, and lets go of its mapping.
+void packAppend(Pack P, int data);
+
+// Other operations -----------------------------------------------------------
+
+// printPack()
+// Writes the elements of P to W as printList() prints them.
+void printPack(Writer W, Pack P);
+
+// List files -----------------------------------------------------------------
+
+// A List file is a 32 byte header followed by the elements as native ints,
+// front first, so that it can be mapped and read in place. The header holds
+// the magic "LIST", the format version, a byte order mark, sizeof(int), the
+// length and a checksum of the elements.
+
+// writeListFile()
+// Writes the n ints of data to out as a List file. Returns 0, or -1 with
+// errno set if writing fails.
+int writeListFile(FILE* out, const int* data, int n);
+
+// readListFile()
+// Reads a List file from in. Returns a new array of its elements, to be
+// freed by the caller, and sets *pLength to their number. Returns NULL,
+// with errno set, if reading fails, or EINVAL if in holds no List or its
+// checksum does not match.
+int* readListFile(FILE* in, int* pLength);
+
+#endif
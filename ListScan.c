@@ -0,0 +1,325 @@
+/*
+ * File:   ListScan.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include "ListScan.h"
+
+// The vector kernels need GCC or Clang on x86, for target attributes,
+// intrinsics and __builtin_cpu_supports(). Defining LIST_SCAN_SCALAR
+// leaves only the scalar loops, to compare against.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(LIST_SCAN_SCALAR)
+#define SCAN_VECTOR
+#include<immintrin.h>
+#endif
+
+// Scalar kernels -------------------------------------------------------------
+
+// findScalar()
+// Returns the offset of the first of the n ints of a equal to x, or -1.
+static int findScalar(const int* a, int n, int x) {
+    for (int i = 0; i < n; i++) {
+        if (a[i] == x) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// countScalar()
+// Returns the number of the n ints of a equal to x.
+static int countScalar(const int* a, int n, int x) {
+    int c = 0;
+    for (int i = 0; i < n; i++) {
+        c += (a[i] == x);
+    }
+    return c;
+}
+
+// sumScalar()
+// Returns the sum of the n ints of a.
+static long long sumScalar(const int* a, int n) {
+    long long s = 0;
+    for (int i = 0; i < n; i++) {
+        s += a[i];
+    }
+    return s;
+}
+
+// minScalar()
+// Returns the least of the n ints of a. Pre: n > 0
+static int minScalar(const int* a, int n) {
+    int m = a[0];
+    for (int i = 1; i < n; i++) {
+        m = (a[i] < m ? a[i] : m);
+    }
+    return m;
+}
+
+// maxScalar()
+// Returns the greatest of the n ints of a. Pre: n > 0
+static int maxScalar(const int* a, int n) {
+    int m = a[0];
+    for (int i = 1; i < n; i++) {
+        m = (a[i] > m ? a[i] : m);
+    }
+    return m;
+}
+
+#ifdef SCAN_VECTOR
+
+// AVX2 kernels ---------------------------------------------------------------
+
+// Each handles the whole vectors of a, 16 or 8 ints at a time, and leaves
+// the remaining few to the scalar kernel.
+
+__attribute__((target("avx2")))
+static int findAVX2(const int* a, int n, int x) {
+    __m256i v = _mm256_set1_epi32(x);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i e0 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), v);
+        __m256i e1 = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i + 8)), v);
+        if (!_mm256_testz_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e0, e1))) {
+            unsigned m = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(e0)) |
+                         (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(e1)) << 8;
+            return i + __builtin_ctz(m);
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256i e = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), v);
+        unsigned m = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(e));
+        if (m != 0) {
+            return i + __builtin_ctz(m);
+        }
+    }
+    int j = findScalar(a + i, n - i, x);
+    return (j < 0 ? -1 : i + j);
+}
+
+__attribute__((target("avx2")))
+static int countAVX2(const int* a, int n, int x) {
+    __m256i v = _mm256_set1_epi32(x);
+    __m256i c = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // a match compares as -1
+        c = _mm256_sub_epi32(c, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), v));
+    }
+    __m128i h = _mm_add_epi32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+    h = _mm_add_epi32(h, _mm_shuffle_epi32(h, 0x4e));
+    h = _mm_add_epi32(h, _mm_shuffle_epi32(h, 0xb1));
+    return _mm_cvtsi128_si32(h) + countScalar(a + i, n - i, x);
+}
+
+__attribute__((target("avx2")))
+static long long sumAVX2(const int* a, int n) {
+    __m256i s0 = _mm256_setzero_si256();
+    __m256i s1 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_add_epi64(s0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i))));
+        s1 = _mm256_add_epi64(s1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(a + i + 4))));
+    }
+    s0 = _mm256_add_epi64(s0, s1);
+    __m128i h = _mm_add_epi64(_mm256_castsi256_si128(s0), _mm256_extracti128_si256(s0, 1));
+    h = _mm_add_epi64(h, _mm_unpackhi_epi64(h, h));
+    long long s;
+    _mm_storel_epi64((__m128i*)&s, h);
+    return s + sumScalar(a + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int minAVX2(const int* a, int n) {
+    if (n < 8) {
+        return minScalar(a, n);
+    }
+    __m256i m = _mm256_loadu_si256((const __m256i*)a);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) {
+        m = _mm256_min_epi32(m, _mm256_loadu_si256((const __m256i*)(a + i)));
+    }
+    // the last vector may overlap the previous ones, which min() allows
+    m = _mm256_min_epi32(m, _mm256_loadu_si256((const __m256i*)(a + n - 8)));
+    __m128i h = _mm_min_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+    h = _mm_min_epi32(h, _mm_shuffle_epi32(h, 0x4e));
+    h = _mm_min_epi32(h, _mm_shuffle_epi32(h, 0xb1));
+    return _mm_cvtsi128_si32(h);
+}
+
+__attribute__((target("avx2")))
+static int maxAVX2(const int* a, int n) {
+    if (n < 8) {
+        return maxScalar(a, n);
+    }
+    __m256i m = _mm256_loadu_si256((const __m256i*)a);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) {
+        m = _mm256_max_epi32(m, _mm256_loadu_si256((const __m256i*)(a + i)));
+    }
+    m = _mm256_max_epi32(m, _mm256_loadu_si256((const __m256i*)(a + n - 8)));
+    __m128i h = _mm_max_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+    h = _mm_max_epi32(h, _mm_shuffle_epi32(h, 0x4e));
+    h = _mm_max_epi32(h, _mm_shuffle_epi32(h, 0xb1));
+    return _mm_cvtsi128_si32(h);
+}
+
+// SSE4.1 kernels -------------------------------------------------------------
+
+__attribute__((target("sse4.1")))
+static int findSSE41(const int* a, int n, int x) {
+    __m128i v = _mm_set1_epi32(x);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i e0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i)), v);
+        __m128i e1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i + 4)), v);
+        unsigned m = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(e0)) |
+                     (unsigned)_mm_movemask_ps(_mm_castsi128_ps(e1)) << 4;
+        if (m != 0) {
+            return i + __builtin_ctz(m);
+        }
+    }
+    int j = findScalar(a + i, n - i, x);
+    return (j < 0 ? -1 : i + j);
+}
+
+__attribute__((target("sse4.1")))
+static int countSSE41(const int* a, int n, int x) {
+    __m128i v = _mm_set1_epi32(x);
+    __m128i c = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c = _mm_sub_epi32(c, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i)), v));
+    }
+    c = _mm_add_epi32(c, _mm_shuffle_epi32(c, 0x4e));
+    c = _mm_add_epi32(c, _mm_shuffle_epi32(c, 0xb1));
+    return _mm_cvtsi128_si32(c) + countScalar(a + i, n - i, x);
+}
+
+__attribute__((target("sse4.1")))
+static long long sumSSE41(const int* a, int n) {
+    __m128i s0 = _mm_setzero_si128();
+    __m128i s1 = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i e = _mm_loadu_si128((const __m128i*)(a + i));
+        s0 = _mm_add_epi64(s0, _mm_cvtepi32_epi64(e));
+        s1 = _mm_add_epi64(s1, _mm_cvtepi32_epi64(_mm_unpackhi_epi64(e, e)));
+    }
+    s0 = _mm_add_epi64(s0, s1);
+    s0 = _mm_add_epi64(s0, _mm_unpackhi_epi64(s0, s0));
+    long long s;
+    _mm_storel_epi64((__m128i*)&s, s0);
+    return s + sumScalar(a + i, n - i);
+}
+
+__attribute__((target("sse4.1")))
+static int minSSE41(const int* a, int n) {
+    if (n < 4) {
+        return minScalar(a, n);
+    }
+    __m128i m = _mm_loadu_si128((const __m128i*)a);
+    for (int i = 4; i + 4 <= n; i += 4) {
+        m = _mm_min_epi32(m, _mm_loadu_si128((const __m128i*)(a + i)));
+    }
+    m = _mm_min_epi32(m, _mm_loadu_si128((const __m128i*)(a + n - 4)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, 0x4e));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, 0xb1));
+    return _mm_cvtsi128_si32(m);
+}
+
+__attribute__((target("sse4.1")))
+static int maxSSE41(const int* a, int n) {
+    if (n < 4) {
+        return maxScalar(a, n);
+    }
+    __m128i m = _mm_loadu_si128((const __m128i*)a);
+    for (int i = 4; i + 4 <= n; i += 4) {
+        m = _mm_max_epi32(m, _mm_loadu_si128((const __m128i*)(a + i)));
+    }
+    m = _mm_max_epi32(m, _mm_loadu_si128((const __m128i*)(a + n - 4)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, 0x4e));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, 0xb1));
+    return _mm_cvtsi128_si32(m);
+}
+
+// hasAVX2()
+// Returns true (1) iff CPUID reports AVX2.
+static int hasAVX2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+// hasSSE41()
+// Returns true (1) iff CPUID reports SSE4.1.
+static int hasSSE41(void) {
+    return __builtin_cpu_supports("sse4.1");
+}
+
+#endif
+
+// Exported kernels -----------------------------------------------------------
+
+// scanFind()
+// Returns the offset of the first of the n ints of a equal to x, or -1.
+int scanFind(const int* a, int n, int x) {
+#ifdef SCAN_VECTOR
+    if (hasAVX2()) return findAVX2(a, n, x);
+    if (hasSSE41()) return findSSE41(a, n, x);
+#endif
+    return findScalar(a, n, x);
+}
+
+// scanCount()
+// Returns the number of the n ints of a equal to x.
+int scanCount(const int* a, int n, int x) {
+#ifdef SCAN_VECTOR
+    if (hasAVX2()) return countAVX2(a, n, x);
+    if (hasSSE41()) return countSSE41(a, n, x);
+#endif
+    return countScalar(a, n, x);
+}
+
+// scanSum()
+// Returns the sum of the n ints of a.
+long long scanSum(const int* a, int n) {
+#ifdef SCAN_VECTOR
+    if (hasAVX2()) return sumAVX2(a, n);
+    if (hasSSE41()) return sumSSE41(a, n);
+#endif
+    return sumScalar(a, n);
+}
+
+// scanMin()
+// Returns the least of the n ints of a.
+// Pre: n > 0
+int scanMin(const int* a, int n) {
+#ifdef SCAN_VECTOR
+    if (hasAVX2()) return minAVX2(a, n);
+    if (hasSSE41()) return minSSE41(a, n);
+#endif
+    return minScalar(a, n);
+}
+
+// scanMax()
+// Returns the greatest of the n ints of a.
+// Pre: n > 0
+int scanMax(const int* a, int n) {
+#ifdef SCAN_VECTOR
+    if (hasAVX2()) return maxAVX2(a, n);
+    if (hasSSE41()) return maxSSE41(a, n);
+#endif
+    return maxScalar(a, n);
+}
+
+// scanKernel()
+// Returns the name of the kernels in use: "avx2", "sse4.1" or "scalar".
+const char* scanKernel(void) {
+#ifdef SCAN_VECTOR
+    if (hasAVX2()) return "avx2";
+    if (hasSSE41()) return "sse4.1";
+#endif
+    return "scalar";
+}
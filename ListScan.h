@@ -0,0 +1,43 @@
+/*
+ * File:   ListScan.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ * Search and aggregate kernels over runs of ints, behind find(), count(),
+ * sumList(), minList() and maxList() of List.c and ListBlock.c. Clients
+ * never include this file themselves; ScanBench.c only asks scanKernel().
+ */
+
+#ifndef LIST_SCAN_H_INCLUDE_
+#define LIST_SCAN_H_INCLUDE_
+
+// Each kernel runs on AVX2 or SSE4.1 if CPUID reports it, and on a scalar
+// loop otherwise, off x86, or when ListScan.c is built with
+// LIST_SCAN_SCALAR.
+
+// scanFind()
+// Returns the offset of the first of the n ints of a equal to x, or -1.
+int scanFind(const int* a, int n, int x);
+
+// scanCount()
+// Returns the number of the n ints of a equal to x.
+int scanCount(const int* a, int n, int x);
+
+// scanSum()
+// Returns the sum of the n ints of a.
+long long scanSum(const int* a, int n);
+
+// scanMin()
+// Returns the least of the n ints of a.
+// Pre: n > 0
+int scanMin(const int* a, int n);
+
+// scanMax()
+// Returns the greatest of the n ints of a.
+// Pre: n > 0
+int scanMax(const int* a, int n);
+
+// scanKernel()
+// Returns the name of the kernels in use: "avx2", "sse4.1" or "scalar".
+const char* scanKernel(void);
+
+#endif
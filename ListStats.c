@@ -0,0 +1,229 @@
+/*
+ * File:   ListStats.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<pthread.h>
+#include "List.h"
+#include "ListStats.h"
+
+#ifdef LIST_STATS
+
+// Names of the kinds of operation, in the order of ListOp.
+static const char* op_names[LIST_OPS] = {
+    "insert", "delete", "seek", "scan", "sort", "copy", "splice", "io"
+};
+
+// Every thread's totals, newest first, guarded by stats_mutex.
+static StatsObj* all_stats = NULL;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+_Thread_local StatsObj* thread_stats = NULL;
+
+// Private functions ----------------------------------------------------------
+
+// now()
+// Returns the time of the monotonic clock in nanoseconds.
+static long long now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// bump()
+// Adds one to the count at p, a count of this thread's StatsObj.
+static void bump(unsigned long long* p) {
+    __atomic_store_n(p, *p + 1, __ATOMIC_RELAXED);
+}
+
+// load()
+// Returns the count at p, which its thread may be changing.
+static unsigned long long load(const unsigned long long* p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+// bucket()
+// Returns the latency histogram bucket of a call that took ns nanoseconds.
+static int bucket(long long ns) {
+    int b = 0;
+    while (b < LIST_LATENCY_BUCKETS - 1 && ns >= (2LL << b)) {
+        b++;
+    }
+    return b;
+}
+
+// percentile()
+// Returns the upper bound, in nanoseconds, of the bucket of kind op of S
+// holding the sampled call at fraction q of the way from fastest to slowest.
+static long long percentile(const ListStats* S, int op, double q) {
+    unsigned long long rank = (unsigned long long)(q * (S->sampled[op] - 1));
+    unsigned long long seen = 0;
+    int b = 0;
+    for (; b < LIST_LATENCY_BUCKETS - 1; b++) {
+        seen += S->latency[op][b];
+        if (seen > rank) {
+            break;
+        }
+    }
+    return 2LL << b;
+}
+
+// Statistics functions -------------------------------------------------------
+
+// threadStats()
+// Returns the totals of this thread, creating them on first use.
+StatsObj* threadStats(void) {
+    if (thread_stats == NULL) {
+        StatsObj* T = calloc(1, sizeof(StatsObj));
+        for (int op = 0; op < LIST_OPS; op++) {
+            T->countdown[op] = 1;
+        }
+        pthread_mutex_lock(&stats_mutex);
+        T->next = all_stats;
+        all_stats = T;
+        pthread_mutex_unlock(&stats_mutex);
+        thread_stats = T;
+    }
+    return thread_stats;
+}
+
+// statStart()
+// Counts a call of kind op and starts timing it if it is sampled. Calls
+// made inside another timed call are neither counted nor timed.
+StatTimer statStart(int op) {
+    StatsObj* T = threadStats();
+    StatTimer t = { -1, -1 };
+    if (T->depth++ > 0) {
+        return t;
+    }
+    t.op = op;
+    bump(&T->calls[op]);
+    if (--T->countdown[op] == 0) {
+        T->countdown[op] = LIST_STATS_SAMPLE;
+        t.start = now();
+    }
+    return t;
+}
+
+// statStop()
+// Ends the call timed by t, adding its latency to the histogram of its
+// kind if it was sampled.
+void statStop(StatTimer* t) {
+    StatsObj* T = thread_stats;
+    T->depth--;
+    if (t->start < 0) {
+        return;
+    }
+    long long ns = now() - t->start;
+    bump(&T->sampled[t->op]);
+    bump(&T->latency[t->op][bucket(ns)]);
+}
+
+// statRead()
+// Fills *out with the List counters counts, or with the totals of every
+// thread if counts is NULL.
+void statRead(const unsigned long long* counts, ListStats* out) {
+    unsigned long long c[STAT_COUNTERS] = { 0 };
+    memset(out, 0, sizeof(ListStats));
+    if (counts != NULL) {
+        memcpy(c, counts, sizeof(c));
+    }
+    else {
+        pthread_mutex_lock(&stats_mutex);
+        for (StatsObj* T = all_stats; T != NULL; T = T->next) {
+            for (int k = 0; k < STAT_COUNTERS; k++) {
+                c[k] += load(&T->count[k]);
+            }
+            for (int op = 0; op < LIST_OPS; op++) {
+                out->calls[op] += load(&T->calls[op]);
+                out->sampled[op] += load(&T->sampled[op]);
+                for (int b = 0; b < LIST_LATENCY_BUCKETS; b++) {
+                    out->latency[op][b] += load(&T->latency[op][b]);
+                }
+            }
+        }
+        pthread_mutex_unlock(&stats_mutex);
+    }
+    out->nodes_allocated = c[STAT_NODES_ALLOCATED];
+    out->nodes_freed = c[STAT_NODES_FREED];
+    out->cursor_steps = c[STAT_CURSOR_STEPS];
+    out->copies = c[STAT_COPIES];
+    out->concats = c[STAT_CONCATS];
+    out->bytes_copied = c[STAT_BYTES_COPIED];
+}
+
+// Other operations -----------------------------------------------------------
+
+// printListStats()
+// Prints the counters of S to out as text, followed by the calls, median
+// and 99th percentile latency, and histogram of every kind of operation
+// that was timed.
+// Pre: out != NULL, S != NULL
+void printListStats(FILE* out, const ListStats* S) {
+    if (out == NULL || S == NULL) {
+        fprintf(stderr, "List Error: calling printListStats() on NULL reference\n");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(out, "nodes allocated  %llu\n", S->nodes_allocated);
+    fprintf(out, "nodes freed      %llu\n", S->nodes_freed);
+    fprintf(out, "cursor steps     %llu\n", S->cursor_steps);
+    fprintf(out, "copies           %llu\n", S->copies);
+    fprintf(out, "concats          %llu\n", S->concats);
+    fprintf(out, "bytes copied     %llu\n", S->bytes_copied);
+    for (int op = 0; op < LIST_OPS; op++) {
+        if (S->sampled[op] == 0) {
+            continue;
+        }
+        fprintf(out, "%-8s %llu calls, %llu timed, p50 < %lld ns, p99 < %lld ns\n",
+                op_names[op], S->calls[op], S->sampled[op],
+                percentile(S, op, 0.5), percentile(S, op, 0.99));
+        for (int b = 0; b < LIST_LATENCY_BUCKETS; b++) {
+            if (S->latency[op][b] > 0) {
+                char range[48];
+                snprintf(range, sizeof(range), "%lld-%lld ns", (b == 0 ? 0 : 1LL << b), 2LL << b);
+                fprintf(out, "  %-24s %llu\n", range, S->latency[op][b]);
+            }
+        }
+    }
+}
+
+// printListStatsJSON()
+// Prints the counters of S to out as one JSON object on a line.
+// Pre: out != NULL, S != NULL
+void printListStatsJSON(FILE* out, const ListStats* S) {
+    if (out == NULL || S == NULL) {
+        fprintf(stderr, "List Error: calling printListStatsJSON() on NULL reference\n");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(out, "{\"nodes_allocated\":%llu,\"nodes_freed\":%llu,\"cursor_steps\":%llu,"
+            "\"copies\":%llu,\"concats\":%llu,\"bytes_copied\":%llu,\"operations\":{",
+            S->nodes_allocated, S->nodes_freed, S->cursor_steps,
+            S->copies, S->concats, S->bytes_copied);
+    const char* comma = "";
+    for (int op = 0; op < LIST_OPS; op++) {
+        if (S->calls[op] == 0) {
+            continue;
+        }
+        fprintf(out, "%s\"%s\":{\"calls\":%llu,\"sampled\":%llu,\"latency_ns\":[",
+                comma, op_names[op], S->calls[op], S->sampled[op]);
+        const char* sep = "";
+        for (int b = 0; b < LIST_LATENCY_BUCKETS; b++) {
+            if (S->latency[op][b] > 0) {
+                fprintf(out, "%s[%lld,%llu]", sep, (b == 0 ? 0 : 1LL << b), S->latency[op][b]);
+                sep = ",";
+            }
+        }
+        fprintf(out, "]}");
+        comma = ",";
+    }
+    fprintf(out, "}}\n");
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * File:   ListStats.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ * Counting and latency sampling behind listStats(), shared by List.c and
+ * ListBlock.c, which include it after List.h and define LIST_COUNTS(L) to
+ * the counters of L. Clients never include this file themselves. Without
+ * LIST_STATS the STAT_ macros below expand to nothing.
+ */
+
+#ifndef LIST_STATS_H_INCLUDE_
+#define LIST_STATS_H_INCLUDE_
+
+#ifdef LIST_STATS
+
+// One call in this many of every kind of operation is timed.
+#ifndef LIST_STATS_SAMPLE
+#define LIST_STATS_SAMPLE 64
+#endif
+
+// Counters, in the order of the fields of ListStats they fill.
+enum {
+    STAT_NODES_ALLOCATED,
+    STAT_NODES_FREED,
+    STAT_CURSOR_STEPS,
+    STAT_COPIES,
+    STAT_CONCATS,
+    STAT_BYTES_COPIED,
+    STAT_COUNTERS
+};
+
+// Bytes of counters each List keeps right after its lock.
+#define STAT_BYTES (STAT_COUNTERS * sizeof(unsigned long long))
+
+// private StatsObj type
+// The totals of one thread. Only that thread writes them, with relaxed
+// atomic stores, so that listStats() may read them from any other without
+// a lock on every count. They outlive their thread.
+typedef struct StatsObj {
+    unsigned long long count[STAT_COUNTERS];
+    unsigned long long calls[LIST_OPS];
+    unsigned long long sampled[LIST_OPS];
+    unsigned long long latency[LIST_OPS][LIST_LATENCY_BUCKETS];
+    int countdown[LIST_OPS];    // calls left until the next timed one
+    int depth;                  // timed operations under way, one inside another
+    struct StatsObj* next;
+} StatsObj;
+
+// private StatTimer type
+// An operation being timed: its kind, or -1 if it runs inside another, and
+// its start in nanoseconds, or -1 if it is not sampled.
+typedef struct StatTimer {
+    int op;
+    long long start;
+} StatTimer;
+
+// The totals of this thread, NULL until it first counts something.
+extern _Thread_local StatsObj* thread_stats;
+
+// threadStats()
+// Returns the totals of this thread, creating them on first use.
+StatsObj* threadStats(void);
+
+// statAdd()
+// Adds n to counter c of the List counters counts and of this thread.
+static inline void statAdd(unsigned long long* counts, int c, unsigned long long n) {
+    StatsObj* T = (thread_stats != NULL ? thread_stats : threadStats());
+    counts[c] += n;
+    __atomic_store_n(&T->count[c], T->count[c] + n, __ATOMIC_RELAXED);
+}
+
+// statInit()
+// Zeroes the List counters counts.
+static inline void statInit(unsigned long long* counts) {
+    for (int c = 0; c < STAT_COUNTERS; c++) {
+        counts[c] = 0;
+    }
+}
+
+// statStart()
+// Counts a call of kind op and starts timing it if it is sampled.
+StatTimer statStart(int op);
+
+// statStop()
+// Ends the call timed by T, adding its latency to the histogram of its kind
+// if it was sampled.
+void statStop(StatTimer* T);
+
+// statRead()
+// Fills *out with the List counters counts, or with the totals of every
+// thread if counts is NULL.
+void statRead(const unsigned long long* counts, ListStats* out);
+
+// STAT_INIT(), STAT_ADD()
+// Zero, or add n to counter c of, List L and its thread.
+#define STAT_INIT(L) statInit(LIST_COUNTS(L))
+#define STAT_ADD(L, c, n) statAdd(LIST_COUNTS(L), (c), (n))
+
+// STAT_TIME()
+// Times the rest of the enclosing function as a call of kind op. The timer
+// stops when the function returns, by any path.
+#define STAT_TIME(op) StatTimer stat_timer __attribute__((cleanup(statStop))) = statStart(op)
+
+#else
+
+#define STAT_BYTES 0
+#define STAT_INIT(L) ((void)0)
+#define STAT_ADD(L, c, n) ((void)0)
+#define STAT_TIME(op) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,351 @@
+/*
+ * File:   ListTemplate.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ * Generator for Lists of any element type. DEFINE_LIST(Name, T) defines the
+ * type Name, a reference to a doubly linked list of T with a cursor, and the
+ * core List operations on it, named after those of List.h with Name
+ * appended: newName(), freeName(), lengthName(), getName(), appendName(),
+ * sortName() and so on. Everything is static inline, so any number of files
+ * may instantiate the same Name. List.h remains the int instantiation, with
+ * its positional index, bulk operations and copy-on-write snapshots.
+ *
+ * Errors are reported as in List.c, or only assert()ed with LIST_UNCHECKED.
+ */
+
+#ifndef LIST_TEMPLATE_H_INCLUDE_
+#define LIST_TEMPLATE_H_INCLUDE_
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<assert.h>
+
+// Nodes are carved out of chunks that double in size from
+// LIST_TEMPLATE_MIN_CHUNK up to LIST_TEMPLATE_MAX_CHUNK nodes.
+#define LIST_TEMPLATE_MIN_CHUNK 16
+#define LIST_TEMPLATE_MAX_CHUNK 4096
+
+// LIST_TEMPLATE_FAIL_IF()
+// Reports msg and exits if the precondition failure cond holds. With
+// LIST_UNCHECKED it is only an assert(), which NDEBUG compiles out.
+#ifdef LIST_UNCHECKED
+#define LIST_TEMPLATE_FAIL_IF(cond, msg) assert(!(cond))
+#else
+#define LIST_TEMPLATE_FAIL_IF(cond, msg) \
+    do { if (cond) { fputs(msg, stderr); exit(EXIT_FAILURE); } } while (0)
+#endif
+
+// DEFINE_LIST()
+// Defines the List type Name of elements of type T and its operations.
+// sortName() takes a comparison function int cmp(T, T, void* ctx).
+#define DEFINE_LIST(Name, T)                                                   \
+                                                                               \
+typedef struct Name##NodeObj {                                                 \
+    T data;                                                                    \
+    struct Name##NodeObj* next;                                                \
+    struct Name##NodeObj* prev;                                                \
+} Name##NodeObj;                                                               \
+                                                                               \
+typedef struct Name##ChunkObj {                                                \
+    struct Name##ChunkObj* next;                                               \
+    Name##NodeObj nodes[];                                                     \
+} Name##ChunkObj;                                                              \
+                                                                               \
+typedef struct Name##Obj {                                                     \
+    Name##NodeObj* front;                                                      \
+    Name##NodeObj* back;                                                       \
+    Name##NodeObj* cursor;                                                     \
+    int length;                                                                \
+    int cursor_index;                                                          \
+    Name##ChunkObj* chunks;  /* newest first */                                \
+    Name##NodeObj* free;     /* recycled nodes, linked through next */         \
+    int used;                /* nodes handed out from the newest chunk */      \
+    int size;                /* capacity of the newest chunk */                \
+} Name##Obj;                                                                   \
+                                                                               \
+typedef Name##Obj* Name;                                                       \
+                                                                               \
+static inline Name new##Name(void) {                                           \
+    Name L = malloc(sizeof(Name##Obj));                                        \
+    L->front = NULL;                                                           \
+    L->back = NULL;                                                            \
+    L->cursor = NULL;                                                          \
+    L->length = 0;                                                             \
+    L->cursor_index = -1;                                                      \
+    L->chunks = NULL;                                                          \
+    L->free = NULL;                                                            \
+    L->used = 0;                                                               \
+    L->size = 0;                                                               \
+    return L;                                                                  \
+}                                                                              \
+                                                                               \
+static inline void clear##Name(Name L) {                                       \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling clear" #Name       \
+        "() on NULL " #Name " reference\n");                                   \
+    while (L->chunks != NULL) {                                                \
+        Name##ChunkObj* C = L->chunks->next;                                   \
+        free(L->chunks);                                                       \
+        L->chunks = C;                                                         \
+    }                                                                          \
+    L->front = NULL;                                                           \
+    L->back = NULL;                                                            \
+    L->cursor = NULL;                                                          \
+    L->length = 0;                                                             \
+    L->cursor_index = -1;                                                      \
+    L->free = NULL;                                                            \
+    L->used = 0;                                                               \
+    L->size = 0;                                                               \
+}                                                                              \
+                                                                               \
+static inline void free##Name(Name* pL) {                                      \
+    LIST_TEMPLATE_FAIL_IF(pL == NULL || *pL == NULL, #Name " Error: calling "  \
+        "free" #Name "() on NULL " #Name " reference\n");                      \
+    clear##Name(*pL);                                                          \
+    free(*pL);                                                                 \
+    *pL = NULL;                                                                \
+}                                                                              \
+                                                                               \
+static inline Name##NodeObj* newNode##Name(Name L, T data) {                   \
+    Name##NodeObj* N;                                                          \
+    if (L->free != NULL) {                                                     \
+        N = L->free;                                                           \
+        L->free = N->next;                                                     \
+    }                                                                          \
+    else {                                                                     \
+        if (L->chunks == NULL || L->used == L->size) {                         \
+            int size = L->size * 2;                                            \
+            if (size < LIST_TEMPLATE_MIN_CHUNK) size = LIST_TEMPLATE_MIN_CHUNK;\
+            if (size > LIST_TEMPLATE_MAX_CHUNK) size = LIST_TEMPLATE_MAX_CHUNK;\
+            Name##ChunkObj* C = malloc(sizeof(Name##ChunkObj)                  \
+                + size * sizeof(Name##NodeObj));                               \
+            C->next = L->chunks;                                               \
+            L->chunks = C;                                                     \
+            L->used = 0;                                                       \
+            L->size = size;                                                    \
+        }                                                                      \
+        N = &L->chunks->nodes[L->used++];                                      \
+    }                                                                          \
+    N->data = data;                                                            \
+    N->next = NULL;                                                            \
+    N->prev = NULL;                                                            \
+    return N;                                                                  \
+}                                                                              \
+                                                                               \
+static inline void freeNode##Name(Name L, Name##NodeObj* N) {                  \
+    N->next = L->free;                                                         \
+    L->free = N;                                                               \
+}                                                                              \
+                                                                               \
+static inline int length##Name(Name L) {                                       \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling length" #Name      \
+        "() on NULL " #Name " reference\n");                                   \
+    return L->length;                                                          \
+}                                                                              \
+                                                                               \
+static inline int index##Name(Name L) {                                        \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling index" #Name       \
+        "() on NULL " #Name " reference\n");                                   \
+    return (L->cursor == NULL ? -1 : L->cursor_index);                         \
+}                                                                              \
+                                                                               \
+static inline T front##Name(Name L) {                                          \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->length == 0, #Name " Error: "        \
+        "calling front" #Name "() on an empty " #Name "\n");                   \
+    return L->front->data;                                                     \
+}                                                                              \
+                                                                               \
+static inline T back##Name(Name L) {                                           \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->length == 0, #Name " Error: "        \
+        "calling back" #Name "() on an empty " #Name "\n");                    \
+    return L->back->data;                                                      \
+}                                                                              \
+                                                                               \
+static inline T get##Name(Name L) {                                            \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->cursor == NULL, #Name " Error: "     \
+        "calling get" #Name "() on an undefined cursor element\n");            \
+    return L->cursor->data;                                                    \
+}                                                                              \
+                                                                               \
+static inline void moveFront##Name(Name L) {                                   \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling moveFront" #Name   \
+        "() on NULL " #Name " reference\n");                                   \
+    if (L->length > 0) {                                                       \
+        L->cursor = L->front;                                                  \
+        L->cursor_index = 0;                                                   \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static inline void moveBack##Name(Name L) {                                    \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling moveBack" #Name    \
+        "() on NULL " #Name " reference\n");                                   \
+    if (L->length > 0) {                                                       \
+        L->cursor = L->back;                                                   \
+        L->cursor_index = L->length - 1;                                       \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static inline void movePrev##Name(Name L) {                                    \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling movePrev" #Name    \
+        "() on NULL " #Name " reference\n");                                   \
+    if (L->cursor != NULL) {                                                   \
+        L->cursor = L->cursor->prev;                                           \
+        L->cursor_index--;                                                     \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static inline void moveNext##Name(Name L) {                                    \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling moveNext" #Name    \
+        "() on NULL " #Name " reference\n");                                   \
+    if (L->cursor != NULL) {                                                   \
+        L->cursor = L->cursor->next;                                           \
+        L->cursor_index = (L->cursor == NULL ? -1 : L->cursor_index + 1);      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+/* links N into L between P and Q, either of which may be NULL */             \
+static inline void link##Name(Name L, Name##NodeObj* P, Name##NodeObj* N,      \
+                              Name##NodeObj* Q) {                              \
+    N->prev = P;                                                               \
+    N->next = Q;                                                               \
+    if (P == NULL) L->front = N; else P->next = N;                             \
+    if (Q == NULL) L->back = N; else Q->prev = N;                              \
+    L->length++;                                                               \
+}                                                                              \
+                                                                               \
+/* unlinks N from L and recycles it */                                         \
+static inline void unlink##Name(Name L, Name##NodeObj* N) {                    \
+    if (N->prev == NULL) L->front = N->next; else N->prev->next = N->next;     \
+    if (N->next == NULL) L->back = N->prev; else N->next->prev = N->prev;      \
+    L->length--;                                                               \
+    freeNode##Name(L, N);                                                      \
+}                                                                              \
+                                                                               \
+static inline void prepend##Name(Name L, T data) {                             \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling prepend" #Name     \
+        "() on NULL " #Name " reference\n");                                   \
+    link##Name(L, NULL, newNode##Name(L, data), L->front);                     \
+    if (L->cursor != NULL) {                                                   \
+        L->cursor_index++;                                                     \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static inline void append##Name(Name L, T data) {                              \
+    LIST_TEMPLATE_FAIL_IF(L == NULL, #Name " Error: calling append" #Name      \
+        "() on NULL " #Name " reference\n");                                   \
+    link##Name(L, L->back, newNode##Name(L, data), NULL);                      \
+}                                                                              \
+                                                                               \
+static inline void insertBefore##Name(Name L, T data) {                        \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->cursor == NULL, #Name " Error: "     \
+        "calling insertBefore" #Name "() on an undefined cursor element\n");   \
+    link##Name(L, L->cursor->prev, newNode##Name(L, data), L->cursor);         \
+    L->cursor_index++;                                                         \
+}                                                                              \
+                                                                               \
+static inline void insertAfter##Name(Name L, T data) {                         \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->cursor == NULL, #Name " Error: "     \
+        "calling insertAfter" #Name "() on an undefined cursor element\n");    \
+    link##Name(L, L->cursor, newNode##Name(L, data), L->cursor->next);         \
+}                                                                              \
+                                                                               \
+static inline void deleteFront##Name(Name L) {                                 \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->length == 0, #Name " Error: "        \
+        "calling deleteFront" #Name "() on an empty " #Name "\n");             \
+    if (L->cursor == L->front) {                                               \
+        L->cursor = NULL;                                                      \
+        L->cursor_index = -1;                                                  \
+    }                                                                          \
+    else if (L->cursor != NULL) {                                              \
+        L->cursor_index--;                                                     \
+    }                                                                          \
+    unlink##Name(L, L->front);                                                 \
+}                                                                              \
+                                                                               \
+static inline void deleteBack##Name(Name L) {                                  \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->length == 0, #Name " Error: "        \
+        "calling deleteBack" #Name "() on an empty " #Name "\n");              \
+    if (L->cursor == L->back) {                                                \
+        L->cursor = NULL;                                                      \
+        L->cursor_index = -1;                                                  \
+    }                                                                          \
+    unlink##Name(L, L->back);                                                  \
+}                                                                              \
+                                                                               \
+static inline void delete##Name(Name L) {                                      \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || L->cursor == NULL, #Name " Error: "     \
+        "calling delete" #Name "() on an undefined cursor element\n");         \
+    unlink##Name(L, L->cursor);                                                \
+    L->cursor = NULL;                                                          \
+    L->cursor_index = -1;                                                      \
+}                                                                              \
+                                                                               \
+/* merges the sorted NULL terminated chains A and B, A first on ties */        \
+static inline Name##NodeObj* mergeRuns##Name(Name##NodeObj* A,                 \
+        Name##NodeObj* B, int (*cmp)(T, T, void*), void* ctx) {                \
+    Name##NodeObj head;                                                        \
+    Name##NodeObj* E = &head;                                                  \
+    while (A != NULL && B != NULL) {                                           \
+        if (cmp(A->data, B->data, ctx) <= 0) {                                 \
+            E->next = A;                                                       \
+            A = A->next;                                                       \
+        }                                                                      \
+        else {                                                                 \
+            E->next = B;                                                       \
+            B = B->next;                                                       \
+        }                                                                      \
+        E = E->next;                                                           \
+    }                                                                          \
+    E->next = (A != NULL ? A : B);                                             \
+    return head.next;                                                          \
+}                                                                              \
+                                                                               \
+/* the stable natural merge sort of sortList(), see List.h */                  \
+static inline void sort##Name(Name L, int (*cmp)(T, T, void*), void* ctx) {    \
+    LIST_TEMPLATE_FAIL_IF(L == NULL || cmp == NULL, #Name " Error: calling "   \
+        "sort" #Name "() on NULL reference\n");                                \
+    Name##NodeObj* pending[32] = { NULL };                                     \
+    Name##NodeObj* N = L->front;                                               \
+    while (N != NULL) {                                                        \
+        Name##NodeObj* run = N;                                                \
+        Name##NodeObj* last = N;                                               \
+        N = N->next;                                                           \
+        if (N != NULL && cmp(last->data, N->data, ctx) > 0) {                  \
+            last->next = NULL;                                                 \
+            while (N != NULL && cmp(run->data, N->data, ctx) > 0) {            \
+                Name##NodeObj* M = N->next;                                    \
+                N->next = run;                                                 \
+                run = N;                                                       \
+                N = M;                                                         \
+            }                                                                  \
+        }                                                                      \
+        else {                                                                 \
+            while (N != NULL && cmp(last->data, N->data, ctx) <= 0) {          \
+                last = N;                                                      \
+                N = N->next;                                                   \
+            }                                                                  \
+            last->next = NULL;                                                 \
+        }                                                                      \
+        int k = 0;                                                             \
+        while (pending[k] != NULL) {                                           \
+            run = mergeRuns##Name(pending[k], run, cmp, ctx);                  \
+            pending[k++] = NULL;                                               \
+        }                                                                      \
+        pending[k] = run;                                                      \
+    }                                                                          \
+    Name##NodeObj* sorted = NULL;                                              \
+    for (int k = 0; k < 32; k++) {                                             \
+        if (pending[k] != NULL) {                                              \
+            sorted = mergeRuns##Name(pending[k], sorted, cmp, ctx);            \
+        }                                                                      \
+    }                                                                          \
+    L->front = sorted;                                                         \
+    L->back = NULL;                                                            \
+    for (N = sorted; N != NULL; N = N->next) {                                 \
+        N->prev = L->back;                                                     \
+        L->back = N;                                                           \
+    }                                                                          \
+    L->cursor = NULL;                                                          \
+    L->cursor_index = -1;                                                      \
+}
+
+#endif
@@ -0,0 +1,470 @@
+/*
+ * File:   OpBench.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<sys/types.h>
+#include<sys/wait.h>
+#include<sys/resource.h>
+#include "List.h"
+
+#define USAGE "Usage: OpBench [-l lex] [min lines] [max lines]\n"
+
+// Elements every List test visits in all, over as many rounds as that takes,
+// so that small sizes are timed over more than a few microseconds.
+#define WORK 10000000
+
+static const char* levels[] = { "DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR" };
+static const char* paths[] = { "/api/v1/users", "/api/v1/orders", "/api/v1/orders/items",
+	"/api/v2/search", "/static/app.js", "/healthz" };
+
+// private Result type
+// What a test did: the operations it timed, the bytes they read or wrote
+// (0 if that means nothing for the test), their seconds, and a checksum
+// that keeps the loops from being optimized away.
+typedef struct Result {
+	long long ops;
+	long long bytes;
+	double seconds;
+	long long sum;
+} Result;
+
+// nextRandom()
+// Returns the next value of a fixed linear congruential sequence, so that
+// every run works on the same data.
+unsigned long nextRandom(void) {
+	static unsigned long long state = 88172645463325252ULL;
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (unsigned long)(state >> 33);
+}
+
+// elapsed()
+// Returns the seconds from start to now.
+double elapsed(struct timespec start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// rounds()
+// Returns how many times a test on n elements runs to visit WORK of them.
+int rounds(int n) {
+	return n >= WORK ? 1 : WORK / n;
+}
+
+// fill()
+// Returns a new List of n random elements.
+List fill(int n) {
+	List L = newList();
+	for (int i = 0; i < n; i++) {
+		append(L, (int)(nextRandom() % 2000001) - 1000000);
+	}
+	return L;
+}
+
+// List tests -----------------------------------------------------------------
+
+// benchAppend()
+// Times append() of n elements to an empty List.
+Result benchAppend(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	for (int k = rounds(n); k > 0; k--) {
+		List L = newList();
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < n; i++) {
+			append(L, i);
+		}
+		r.seconds += elapsed(start);
+		r.sum += back(L);
+		r.ops += n;
+		freeList(&L);
+	}
+	return r;
+}
+
+// benchPrepend()
+// Times prepend() of n elements to an empty List.
+Result benchPrepend(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	for (int k = rounds(n); k > 0; k--) {
+		List L = newList();
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < n; i++) {
+			prepend(L, i);
+		}
+		r.seconds += elapsed(start);
+		r.sum += front(L);
+		r.ops += n;
+		freeList(&L);
+	}
+	return r;
+}
+
+// benchWalk()
+// Times a forward and a backward cursor loop over a List of n elements.
+Result benchWalk(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	List L = fill(n);
+	int k = rounds(n);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int j = 0; j < k; j++) {
+		for (moveFront(L); index(L) >= 0; moveNext(L)) {
+			r.sum += get(L);
+		}
+		for (moveBack(L); index(L) >= 0; movePrev(L)) {
+			r.sum -= get(L);
+		}
+	}
+	r.seconds = elapsed(start);
+	r.ops = 2LL * n * k;
+	freeList(&L);
+	return r;
+}
+
+// benchChurn()
+// Times insertBefore() and insertAfter() around every element of a List of
+// n elements, as the cursor walks it.
+Result benchChurn(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	for (int k = rounds(n); k > 0; k--) {
+		List L = fill(n);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		moveFront(L);
+		for (int i = 0; i < n; i++) {
+			insertBefore(L, i);
+			insertAfter(L, -i);
+			// step over the new element to the next old one
+			moveNext(L);
+			moveNext(L);
+		}
+		r.seconds += elapsed(start);
+		r.sum += length(L);
+		r.ops += 2LL * n;
+		freeList(&L);
+	}
+	return r;
+}
+
+// benchDelete()
+// Times deleting n elements from a List, by turns with deleteFront(),
+// deleteBack() and delete() of the second element.
+Result benchDelete(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	for (int k = rounds(n); k > 0; k--) {
+		List L = fill(n + 2);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < n; i++) {
+			switch (i % 3) {
+				case 0:
+					deleteFront(L);
+					break;
+				case 1:
+					deleteBack(L);
+					break;
+				default:
+					moveFront(L);
+					moveNext(L);
+					delete(L);
+			}
+		}
+		r.seconds += elapsed(start);
+		r.sum += front(L);
+		r.ops += n;
+		freeList(&L);
+	}
+	return r;
+}
+
+// benchCopy()
+// Times copyList() of a List of n elements followed by a change to the
+// copy, which makes it copy the elements it shared until then.
+Result benchCopy(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	List L = fill(n);
+	int k = rounds(n);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int j = 0; j < k; j++) {
+		List C = copyList(L);
+		append(C, j);
+		r.sum += length(C);
+		freeList(&C);
+	}
+	r.seconds = elapsed(start);
+	r.ops = k;
+	freeList(&L);
+	return r;
+}
+
+// benchConcat()
+// Times concatList() of two Lists of n/2 elements each.
+Result benchConcat(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	List A = fill(n / 2);
+	List B = fill(n - n / 2);
+	int k = rounds(n);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int j = 0; j < k; j++) {
+		List C = concatList(A, B);
+		r.sum += length(C);
+		freeList(&C);
+	}
+	r.seconds = elapsed(start);
+	r.ops = k;
+	freeList(&A);
+	freeList(&B);
+	return r;
+}
+
+// benchEquals()
+// Times equals() of two Lists of the same n elements, built apart so that
+// every call compares them all.
+Result benchEquals(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	List A = fill(n);
+	List B = newList();
+	for (moveFront(A); index(A) >= 0; moveNext(A)) {
+		append(B, get(A));
+	}
+	int k = rounds(n);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int j = 0; j < k; j++) {
+		r.sum += equals(A, B);
+	}
+	r.seconds = elapsed(start);
+	r.ops = k;
+	freeList(&A);
+	freeList(&B);
+	return r;
+}
+
+// benchPrint()
+// Times printList() of a List of n elements to a temporary file.
+Result benchPrint(int n) {
+	Result r = { 0, 0, 0.0, 0 };
+	struct timespec start;
+	List L = fill(n);
+	FILE* f = tmpfile();
+	if (f == NULL) {
+		perror("OpBench Error: cannot open a temporary file");
+		exit(EXIT_FAILURE);
+	}
+	int k = rounds(n);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int j = 0; j < k; j++) {
+		rewind(f);
+		printList(f, L);
+		fflush(f);
+	}
+	r.seconds = elapsed(start);
+	r.bytes = ftell(f) * (long long)k;
+	r.ops = k;
+	fclose(f);
+	freeList(&L);
+	return r;
+}
+
+// The List tests, in the order they are run.
+static const struct {
+	const char* name;
+	Result (*run)(int n);
+} tests[] = {
+	{ "append", benchAppend },
+	{ "prepend", benchPrepend },
+	{ "walk", benchWalk },
+	{ "insert", benchChurn },
+	{ "delete", benchDelete },
+	{ "copyList", benchCopy },
+	{ "concatList", benchConcat },
+	{ "equals", benchEquals },
+	{ "printList", benchPrint },
+};
+
+// Running tests --------------------------------------------------------------
+
+// report()
+// Prints the result of test name on n lines, and the peak resident memory
+// of the process that ran it, as one JSON object on a line.
+void report(const char* name, int n, Result r, long peak_kb) {
+	printf("{\"bench\":\"%s\",\"lines\":%d,\"ops\":%lld,\"seconds\":%.6f,"
+		"\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f,", name, n, r.ops, r.seconds,
+		r.seconds * 1e9 / r.ops, r.ops / r.seconds);
+	if (r.bytes > 0) {
+		printf("\"mb_per_sec\":%.1f,", r.bytes / r.seconds / 1e6);
+	}
+	else {
+		printf("\"mb_per_sec\":null,");
+	}
+	printf("\"peak_rss_kb\":%ld}\n", peak_kb);
+	fflush(stdout);
+}
+
+// waitFor()
+// Waits for child pid, exiting if it failed, and returns its peak resident
+// memory in kilobytes.
+long waitFor(pid_t pid, const char* name) {
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid) {
+		perror("OpBench Error: cannot wait for a test");
+		exit(EXIT_FAILURE);
+	}
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "OpBench Error: %s failed\n", name);
+		exit(EXIT_FAILURE);
+	}
+	return usage.ru_maxrss;
+}
+
+// runTest()
+// Runs test t on n elements in a child process, so that its peak memory is
+// its own, and reports it.
+void runTest(int t, int n) {
+	int fd[2];
+	Result r;
+	if (pipe(fd) != 0) {
+		perror("OpBench Error: cannot open a pipe");
+		exit(EXIT_FAILURE);
+	}
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("OpBench Error: cannot fork");
+		exit(EXIT_FAILURE);
+	}
+	if (pid == 0) {
+		close(fd[0]);
+		r = tests[t].run(n);
+		_exit(write(fd[1], &r, sizeof(r)) == sizeof(r) ? 0 : 1);
+	}
+	close(fd[1]);
+	ssize_t got = read(fd[0], &r, sizeof(r));
+	close(fd[0]);
+	long peak = waitFor(pid, tests[t].name);
+	if (got != sizeof(r)) {
+		fprintf(stderr, "OpBench Error: %s sent no result\n", tests[t].name);
+		exit(EXIT_FAILURE);
+	}
+	report(tests[t].name, n, r, peak);
+}
+
+// makeInput()
+// Writes n lines of generated log records to a new temporary file, whose
+// name it stores in path, and returns its size in bytes.
+long long makeInput(char* path, size_t size, int n) {
+	const char* dir = getenv("TMPDIR");
+	snprintf(path, size, "%s/OpBench.XXXXXX", dir != NULL && *dir != '\0' ? dir : "/tmp");
+	int fd = mkstemp(path);
+	FILE* f = (fd < 0 ? NULL : fdopen(fd, "w"));
+	if (f == NULL) {
+		perror("OpBench Error: cannot create the Lex input");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < n; i++) {
+		unsigned long r = nextRandom();
+		fprintf(f, "2024-03-%02lu %02lu:%02lu:%02lu.%03lu %s [worker-%lu] GET %s id=%lu\n",
+			1 + r % 28, r / 28 % 24, r / 672 % 60, r / 40320 % 60, nextRandom() % 1000,
+			levels[nextRandom() % 6], nextRandom() % 16, paths[nextRandom() % 6],
+			nextRandom() % 1000000);
+	}
+	long long bytes = ftell(f);
+	if (fclose(f) != 0) {
+		perror("OpBench Error: cannot write the Lex input");
+		exit(EXIT_FAILURE);
+	}
+	return bytes;
+}
+
+// runLex()
+// Times the program lex sorting n generated lines, end to end, and reports
+// it with the peak memory of lex.
+void runLex(const char* lex, int n) {
+	char in[4096], out[4096 + 8];
+	struct timespec start;
+	Result r = { n, 0, 0.0, 0 };
+	r.bytes = makeInput(in, sizeof(in), n);
+	snprintf(out, sizeof(out), "%s.out", in);
+	fflush(stdout);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("OpBench Error: cannot fork");
+		exit(EXIT_FAILURE);
+	}
+	if (pid == 0) {
+		execl(lex, lex, in, out, (char*)NULL);
+		perror("OpBench Error: cannot run Lex");
+		_exit(1);
+	}
+	long peak = waitFor(pid, "Lex");
+	r.seconds = elapsed(start);
+	unlink(in);
+	unlink(out);
+	report("Lex", n, r, peak);
+}
+
+int main(int argc, char* argv[]) {
+	const char* lex = "./Lex";
+	int lo = 1000;
+	int hi = 10000000;
+	char* end;
+	int opt;
+	while ((opt = getopt(argc, argv, "l:")) != -1) {
+		if (opt == 'l') {
+			lex = optarg;
+		}
+		else {
+			fprintf(stderr, USAGE);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (argc - optind > 2) {
+		fprintf(stderr, USAGE);
+		exit(EXIT_FAILURE);
+	}
+	if (argc - optind > 0) {
+		lo = (int)strtol(argv[optind], &end, 10);
+		if (end == argv[optind] || *end != '\0' || lo < 1) {
+			fprintf(stderr, "Error: invalid line count '%s'\n", argv[optind]);
+			exit(EXIT_FAILURE);
+		}
+		hi = lo > hi ? lo : hi;
+	}
+	if (argc - optind > 1) {
+		hi = (int)strtol(argv[optind + 1], &end, 10);
+		if (end == argv[optind + 1] || *end != '\0' || hi < lo) {
+			fprintf(stderr, "Error: invalid line count '%s'\n", argv[optind + 1]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	int have_lex = access(lex, X_OK) == 0;
+	if (!have_lex) {
+		fprintf(stderr, "OpBench: no program %s, skipping Lex\n", lex);
+	}
+	// sizes go up by tens from lo, so the default runs 10^3 to 10^7 lines
+	for (long n = lo; n <= hi; n *= 10) {
+		for (int t = 0; t < (int)(sizeof(tests) / sizeof(tests[0])); t++) {
+			runTest(t, (int)n);
+		}
+		if (have_lex) {
+			runLex(lex, (int)n);
+		}
+	}
+	return 0;
+}
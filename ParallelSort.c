@@ -0,0 +1,188 @@
+/*
+ * File:   ParallelSort.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+#include "List.h"
+#include "ParallelSort.h"
+
+// Partitions smaller than this are not worth a thread of their own.
+#ifndef MIN_PARTITION
+#define MIN_PARTITION 4096
+#endif
+
+// private SortJobObj type: state shared by every worker of one sort
+typedef struct SortJobObj {
+    const LineTable* table;
+    LineSorter sorter;          // partition sort, or NULL for sortList()
+    int* a;                     // runs of the current level
+    int* b;                     // output of the current level
+    int n;
+    int threads;
+    int runs;
+    int* bound;                 // run r is a[bound[r]..bound[r+1])
+    pthread_barrier_t barrier;
+} SortJobObj;
+
+// private WorkerObj type
+typedef struct WorkerObj {
+    SortJobObj* job;
+    int id;
+    pthread_t thread;
+} WorkerObj;
+
+// lineAfter()
+// Returns true (1) iff line x goes after line y in table.
+static inline int lineAfter(const LineTable* table, int x, int y) {
+    return compareViews(table->text, table->view[x], table->view[y]) > 0;
+}
+
+// mergePath()
+// Returns how many of the first d elements of the stable merge of sorted
+// runs A (na long) and B (nb long) come from A.
+static int mergePath(const LineTable* table, const int* A, int na, const int* B, int nb, int d) {
+    int lo = (d > nb ? d - nb : 0);
+    int hi = (d < na ? d : na);
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (lineAfter(table, A[mid], B[d - mid - 1])) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// mergeRange()
+// Writes outputs d0 up to d1 of the stable merge of runs A and B to out.
+static void mergeRange(const LineTable* table, const int* A, int na, const int* B, int nb,
+                       int d0, int d1, int* out) {
+    int i = mergePath(table, A, na, B, nb, d0);
+    int j = d0 - i;
+    for (int d = d0; d < d1; d++) {
+        if (j >= nb || (i < na && !lineAfter(table, A[i], B[j]))) {
+            out[d] = A[i++];
+        }
+        else {
+            out[d] = B[j++];
+        }
+    }
+}
+
+// sortPartition()
+// Sorts a[lo..hi) with sorter, or with a List as the serial path does if
+// sorter is NULL.
+static void sortPartition(const LineTable* table, LineSorter sorter, int* a, int lo, int hi) {
+    if (sorter != NULL) {
+        sorter(table, a + lo, hi - lo);
+        return;
+    }
+    List A = newListFromArray(a + lo, hi - lo);
+    sortList(A, compareLines, (void*)table);
+    toArray(A, a + lo, hi - lo);
+    freeList(&A);
+}
+
+// work()
+// Body of every worker: sort its own partition, then take an equal share of
+// the output of each merge level.
+static void* work(void* arg) {
+    WorkerObj* W = arg;
+    SortJobObj* J = W->job;
+    int t = W->id;
+    sortPartition(J->table, J->sorter, J->a, J->bound[t], J->bound[t + 1]);
+    pthread_barrier_wait(&J->barrier);
+    while (J->runs > 1) {
+        long lo = (long)J->n * t / J->threads;
+        long hi = (long)J->n * (t + 1) / J->threads;
+        for (int r = 0; r < J->runs; r += 2) {
+            int s = J->bound[r];
+            int m = J->bound[r + 1];
+            int e = (r + 2 <= J->runs ? J->bound[r + 2] : m);
+            if (e <= lo || s >= hi) continue;
+            int d0 = (lo > s ? lo : s) - s;
+            int d1 = (hi < e ? hi : e) - s;
+            mergeRange(J->table, J->a + s, m - s, J->a + m, e - m, d0, d1, J->b + s);
+        }
+        if (pthread_barrier_wait(&J->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            for (int r = 0; 2 * r < J->runs; r++) {
+                J->bound[r] = J->bound[2 * r];
+            }
+            J->runs = (J->runs + 1) / 2;
+            J->bound[J->runs] = J->n;
+            int* swap = J->a;
+            J->a = J->b;
+            J->b = swap;
+        }
+        pthread_barrier_wait(&J->barrier);
+    }
+    return NULL;
+}
+
+// parallelSort()
+// Sorts the n line indices in order by the lines they refer to in table,
+// as sortList() with compareLines() would, using a pool of threads workers.
+// The indices are cut into one contiguous partition per worker, each
+// partition is sorted with sorter, or with sortList() if sorter is NULL, and
+// the sorted partitions are merged pairwise, level by level, with every
+// level's output split evenly across the workers along merge paths. The
+// merges are stable, so the output is the same for any number of workers.
+// Pre: table != NULL, order != NULL, n >= 0, threads >= 1
+void parallelSort(const LineTable* table, int* order, int n, int threads, LineSorter sorter) {
+    if (table == NULL || order == NULL) {
+        fprintf(stderr, "ParallelSort Error: calling parallelSort() on NULL reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if (n < 0 || threads < 1) {
+        fprintf(stderr, "ParallelSort Error: calling parallelSort() with invalid size\n");
+        exit(EXIT_FAILURE);
+    }
+    if (threads > n / MIN_PARTITION) {
+        threads = (n / MIN_PARTITION > 1 ? n / MIN_PARTITION : 1);
+    }
+    SortJobObj J;
+    J.table = table;
+    J.sorter = sorter;
+    J.a = order;
+    J.b = malloc((n > 0 ? n : 1) * sizeof(int));
+    J.n = n;
+    J.threads = threads;
+    J.runs = threads;
+    J.bound = malloc((threads + 1) * sizeof(int));
+    for (int t = 0; t <= threads; t++) {
+        J.bound[t] = (int)((long)n * t / threads);
+    }
+    pthread_barrier_init(&J.barrier, NULL, threads);
+    WorkerObj* W = malloc(threads * sizeof(WorkerObj));
+    for (int t = 0; t < threads; t++) {
+        W[t].job = &J;
+        W[t].id = t;
+    }
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&W[t].thread, NULL, work, &W[t]) != 0) {
+            fprintf(stderr, "ParallelSort Error: cannot create worker thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    work(&W[0]);
+    for (int t = 1; t < threads; t++) {
+        pthread_join(W[t].thread, NULL);
+    }
+    if (J.a != order) {
+        memcpy(order, J.a, n * sizeof(int));
+        J.b = J.a;
+    }
+    pthread_barrier_destroy(&J.barrier);
+    free(J.b);
+    free(J.bound);
+    free(W);
+}
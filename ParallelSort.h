@@ -0,0 +1,19 @@
+/*
+ * File:   ParallelSort.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ */
+
+#include "Lines.h"
+
+// Other operations -----------------------------------------------------------
+
+// parallelSort()
+// Sorts the n line indices in order by the lines they refer to in table,
+// as sortList() with compareLines() would, using a pool of threads workers.
+// The indices are cut into one contiguous partition per worker, each
+// partition is sorted with sorter, or with sortList() if sorter is NULL, and
+// the sorted partitions are merged pairwise, level by level, with every
+// level's output split evenly across the workers along merge paths. The
+// merges are stable, so the output is the same for any number of workers.
+// Pre: table != NULL, order != NULL, n >= 0, threads >= 1
+void parallelSort(const LineTable* table, int* order, int n, int threads, LineSorter sorter);
@@ -0,0 +1,177 @@
+/*
+ * File:   PrintBench.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<unistd.h>
+#include "List.h"
+#include "Writer.h"
+
+#define USAGE "Usage: PrintBench [element count] [line count]\n"
+
+// Longest generated line, newline included.
+#define MAX_LINE 80
+
+// elapsed()
+// Returns the seconds from start to now.
+double elapsed(struct timespec start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// contents()
+// Returns the text written to f, which is emptied for the next test, and
+// stores its length in *pSize.
+char* contents(FILE* f, size_t* pSize) {
+	fflush(f);
+	long size = ftell(f);
+	char* text = malloc(size > 0 ? size : 1);
+	rewind(f);
+	*pSize = fread(text, 1, size, f);
+	rewind(f);
+	if (ftruncate(fileno(f), 0) != 0) {
+		perror("PrintBench Error: cannot empty the output file");
+		exit(EXIT_FAILURE);
+	}
+	return text;
+}
+
+// compare()
+// Reports the throughput of both ways of writing a test, given the text each
+// wrote and its time, and exits if the texts differ.
+void compare(const char* test, const char* old_way, char* a, size_t a_size, double a_secs,
+             const char* new_way, char* b, size_t b_size, double b_secs) {
+	if (a_size != b_size || memcmp(a, b, a_size) != 0) {
+		fprintf(stderr, "PrintBench Error: %s output of %s and %s differs\n", test, old_way, new_way);
+		exit(EXIT_FAILURE);
+	}
+	printf("%-8s %-10s %8.1f MB/s\n", test, old_way, a_size / a_secs / 1e6);
+	printf("%-8s %-10s %8.1f MB/s\n", test, new_way, b_size / b_secs / 1e6);
+	free(a);
+	free(b);
+}
+
+// benchList()
+// Times printList() on A, holding n random elements of the given storage,
+// against the fprintf() loop it replaces, and frees A.
+void benchList(List A, const char* storage, int n, FILE* f) {
+	struct timespec start;
+	size_t a_size, b_size;
+	for (int i = 0; i < n; i++) {
+		append(A, rand() % 2000001 - 1000000);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (moveFront(A); index(A) >= 0; moveNext(A)) {
+		fprintf(f, "%d ", get(A));
+	}
+	fflush(f);
+	double a_secs = elapsed(start);
+	char* a = contents(f, &a_size);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	printList(f, A);
+	double b_secs = elapsed(start);
+	char* b = contents(f, &b_size);
+
+	compare(storage, "fprintf()", a, a_size, a_secs, "printList()", b, b_size, b_secs);
+	freeList(&A);
+}
+
+// benchLines()
+// Times writing m random lines in shuffled order, as Lex writes sorted
+// ones, with one fwrite() per line against a Writer gathering them.
+void benchLines(int m, FILE* f) {
+	struct timespec start;
+	size_t a_size, b_size;
+	char* text = malloc((size_t)m * MAX_LINE);
+	size_t* offset = malloc(m * sizeof(size_t));
+	int* length = malloc(m * sizeof(int));
+	int* order = malloc(m * sizeof(int));
+	size_t size = 0;
+	for (int i = 0; i < m; i++) {
+		offset[i] = size;
+		length[i] = 1 + rand() % MAX_LINE;
+		for (int j = 0; j < length[i] - 1; j++) {
+			text[size++] = (char)('a' + rand() % 26);
+		}
+		text[size++] = '\n';
+		order[i] = i;
+	}
+	for (int i = m - 1; i > 0; i--) {
+		int j = rand() % (i + 1);
+		int t = order[i];
+		order[i] = order[j];
+		order[j] = t;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < m; i++) {
+		fwrite(text + offset[order[i]], 1, length[order[i]], f);
+	}
+	fflush(f);
+	double a_secs = elapsed(start);
+	char* a = contents(f, &a_size);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	Writer W = newWriter(f);
+	for (int i = 0; i < m; i++) {
+		writeView(W, text + offset[order[i]], length[order[i]]);
+	}
+	if (freeWriter(&W) != 0) {
+		perror("PrintBench Error: writing output failed");
+		exit(EXIT_FAILURE);
+	}
+	double b_secs = elapsed(start);
+	char* b = contents(f, &b_size);
+
+	compare("lines", "fwrite()", a, a_size, a_secs, "writeView()", b, b_size, b_secs);
+	free(text);
+	free(offset);
+	free(length);
+	free(order);
+}
+
+int main(int argc, char* argv[]) {
+	int n = 5000000;
+	int m = 2000000;
+	char* end;
+	if (argc > 3) {
+		fprintf(stderr, USAGE);
+		exit(EXIT_FAILURE);
+	}
+	if (argc > 1) {
+		n = (int)strtol(argv[1], &end, 10);
+		if (end == argv[1] || *end != '\0' || n < 1) {
+			fprintf(stderr, "Error: invalid element count '%s'\n", argv[1]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (argc > 2) {
+		m = (int)strtol(argv[2], &end, 10);
+		if (end == argv[2] || *end != '\0' || m < 1) {
+			fprintf(stderr, "Error: invalid line count '%s'\n", argv[2]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	// a temporary file, so that the page cache takes the writes
+	FILE* f = tmpfile();
+	if (f == NULL) {
+		perror("PrintBench Error: cannot create output file");
+		exit(EXIT_FAILURE);
+	}
+	srand(1);
+	benchList(newList(), "plain", n, f);
+	benchList(newPackedList(), "compact", n, f);
+	benchLines(m, f);
+	fclose(f);
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * File:   ScanBench.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include "List.h"
+#include "ListScan.h"
+
+#define USAGE "Usage: ScanBench [element count] [rounds]\n"
+
+// elapsed()
+// Returns the seconds from start to now.
+double elapsed(struct timespec start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// report()
+// Prints the time per element of a test on a List of the given storage
+// that visited n elements, run as a cursor loop or by the List function.
+void report(const char* storage, const char* test, const char* how, double seconds, long long n) {
+	printf("%-8s %-6s %-9s %8.3f ns/element\n", storage, test, how, seconds * 1e9 / n);
+}
+
+// bench()
+// Times find(), count(), sumList(), minList() and maxList() on A, holding n
+// random elements of the given storage, against the cursor loops they
+// replace, over rounds rounds each, and frees A. Exits if any disagree.
+// Returns a checksum.
+long long bench(List A, const char* storage, int n, int rounds) {
+	struct timespec start;
+	long long loop = 0;
+	long long call = 0;
+	for (int i = 0; i < n; i++) {
+		append(A, rand() % (1 << 20));
+	}
+	int absent = -1;
+
+	//----- find(), of a missing value so every element is visited -----//
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		for (moveFront(A); index(A) >= 0; moveNext(A)) {
+			if (get(A) == absent) {
+				break;
+			}
+		}
+		loop += index(A);
+	}
+	report(storage, "find", "cursor", elapsed(start), (long long)n * rounds);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		call += find(A, absent);
+	}
+	report(storage, "find", "find()", elapsed(start), (long long)n * rounds);
+
+	//----- count() -----//
+	int x = back(A);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		for (moveFront(A); index(A) >= 0; moveNext(A)) {
+			loop += (get(A) == x);
+		}
+	}
+	report(storage, "count", "cursor", elapsed(start), (long long)n * rounds);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		call += count(A, x);
+	}
+	report(storage, "count", "count()", elapsed(start), (long long)n * rounds);
+
+	//----- sumList() -----//
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		for (moveFront(A); index(A) >= 0; moveNext(A)) {
+			loop += get(A);
+		}
+	}
+	report(storage, "sum", "cursor", elapsed(start), (long long)n * rounds);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		call += sumList(A);
+	}
+	report(storage, "sum", "sumList()", elapsed(start), (long long)n * rounds);
+
+	//----- minList() and maxList() together -----//
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		int lo = front(A);
+		int hi = front(A);
+		for (moveFront(A); index(A) >= 0; moveNext(A)) {
+			int e = get(A);
+			lo = (e < lo ? e : lo);
+			hi = (e > hi ? e : hi);
+		}
+		loop += lo + hi;
+	}
+	report(storage, "minmax", "cursor", elapsed(start), 2LL * n * rounds);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int r = 0; r < rounds; r++) {
+		call += minList(A) + maxList(A);
+	}
+	report(storage, "minmax", "min/max", elapsed(start), 2LL * n * rounds);
+
+	if (loop != call) {
+		fprintf(stderr, "Error: %s List functions disagree with the cursor loops\n", storage);
+		exit(EXIT_FAILURE);
+	}
+	freeList(&A);
+	return call;
+}
+
+int main(int argc, char* argv[]) {
+	int n = 1000000;
+	int rounds = 20;
+	char* end;
+	if (argc > 3) {
+		fprintf(stderr, USAGE);
+		exit(EXIT_FAILURE);
+	}
+	if (argc > 1) {
+		n = (int)strtol(argv[1], &end, 10);
+		if (end == argv[1] || *end != '\0' || n < 1) {
+			fprintf(stderr, "Error: invalid element count '%s'\n", argv[1]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (argc > 2) {
+		rounds = (int)strtol(argv[2], &end, 10);
+		if (end == argv[2] || *end != '\0' || rounds < 1) {
+			fprintf(stderr, "Error: invalid round count '%s'\n", argv[2]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	printf("kernels: %s\n", scanKernel());
+	srand(1);
+	long long sum = bench(newList(), "plain", n, rounds);
+	sum += bench(newPackedList(), "compact", n, rounds);
+	// printing the checksum keeps the loops from being optimized away
+	printf("checksum %lld\n", sum);
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * File:   SortBench.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "List.h"
+#include "Lines.h"
+#include "StringSort.h"
+
+#define USAGE "Usage: SortBench [line count]\n"
+
+static const char* levels[] = { "DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR" };
+static const char* paths[] = { "/api/v1/users", "/api/v1/orders", "/api/v1/orders/items",
+	"/api/v2/search", "/static/app.js", "/healthz" };
+static const char* regions[] = { "us-east", "us-west", "eu-central", "ap-south" };
+
+// nextRandom()
+// Returns the next value of a fixed linear congruential sequence, so that
+// every run sorts the same data.
+unsigned long nextRandom(void) {
+	static unsigned long long state = 88172645463325252ULL;
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (unsigned long)(state >> 33);
+}
+
+// makeTable()
+// Fills table with n lines of generated log records if log is set and of CSV
+// rows otherwise, and sets *pview to its views. Returns the text. The caller
+// frees both.
+char* makeTable(LineTable* table, LineView** pview, int n, int log) {
+	size_t capacity = (size_t)n * 128 + 1;
+	char* text = malloc(capacity);
+	LineView* view = malloc((n > 0 ? n : 1) * sizeof(LineView));
+	size_t used = 0;
+	for (int i = 0; i < n; i++) {
+		unsigned long r = nextRandom();
+		int w;
+		if (log) {
+			w = snprintf(text + used, capacity - used,
+				"2024-03-%02lu %02lu:%02lu:%02lu.%03lu %s [worker-%lu] GET %s id=%lu\n",
+				1 + r % 28, r / 28 % 24, r / 672 % 60, r / 40320 % 60, nextRandom() % 1000,
+				levels[nextRandom() % 6], nextRandom() % 16, paths[nextRandom() % 6],
+				nextRandom() % 1000000);
+		}
+		else {
+			w = snprintf(text + used, capacity - used,
+				"customer_%05lu,%s,product_%03lu,%lu.%02lu\n",
+				r % 50000, regions[nextRandom() % 4], nextRandom() % 500,
+				nextRandom() % 10000, nextRandom() % 100);
+		}
+		view[i].offset = used;
+		view[i].length = w;
+		used += w;
+	}
+	table->text = text;
+	table->view = view;
+	*pview = view;
+	return text;
+}
+
+// elapsed()
+// Returns the seconds from start to now.
+double elapsed(struct timespec start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// benchList()
+// Sorts the n lines of table with sortList(), writing the result to order.
+// Returns the seconds taken.
+double benchList(const LineTable* table, int* order, int n) {
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	List A = newList();
+	for (int i = 0; i < n; i++) {
+		append(A, i);
+	}
+	sortList(A, compareLines, (void*)table);
+	int i = 0;
+	for (moveFront(A); index(A) >= 0; moveNext(A)) {
+		order[i++] = get(A);
+	}
+	freeList(&A);
+	return elapsed(start);
+}
+
+// benchRadix()
+// Sorts the n lines of table with radixSort(), writing the result to order.
+// Returns the seconds taken.
+double benchRadix(const LineTable* table, int* order, int n) {
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < n; i++) {
+		order[i] = i;
+	}
+	radixSort(table, order, n);
+	return elapsed(start);
+}
+
+int main(int argc, char* argv[]) {
+	int n = 1000000;
+	char* end;
+	if (argc > 2) {
+		fprintf(stderr, USAGE);
+		exit(EXIT_FAILURE);
+	}
+	if (argc == 2) {
+		n = (int)strtol(argv[1], &end, 10);
+		if (end == argv[1] || *end != '\0' || n < 1) {
+			fprintf(stderr, "Error: invalid line count '%s'\n", argv[1]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	int* a = malloc(n * sizeof(int));
+	int* b = malloc(n * sizeof(int));
+	printf("%-6s %10s %12s %12s %8s\n", "data", "lines", "sortList s", "radixSort s", "speedup");
+	for (int log = 1; log >= 0; log--) {
+		LineTable table;
+		LineView* view;
+		char* text = makeTable(&table, &view, n, log);
+		double list = benchList(&table, a, n);
+		double radix = benchRadix(&table, b, n);
+		for (int i = 0; i < n; i++) {
+			if (compareViews(text, view[a[i]], view[b[i]]) != 0) {
+				fprintf(stderr, "SortBench Error: orders differ at line %d\n", i);
+				exit(EXIT_FAILURE);
+			}
+		}
+		printf("%-6s %10d %12.3f %12.3f %7.2fx\n", (log ? "log" : "csv"), n, list, radix,
+			list / radix);
+		free(text);
+		free(view);
+	}
+	free(a);
+	free(b);
+	return 0;
+}
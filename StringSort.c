@@ -0,0 +1,194 @@
+/*
+ * File:   StringSort.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include "StringSort.h"
+
+// Groups this small are finished by insertion sort.
+#define INSERTION_LIMIT 16
+
+// Bytes of a line held in a cached key.
+#define KEY_BYTES 8
+
+// private KeyObj type: a line index and the cached chunk of its line
+typedef struct KeyObj {
+    uint64_t key;
+    int index;
+} KeyObj;
+
+// loadKey()
+// Returns bytes depth up to depth+KEY_BYTES of line i of T, packed big end
+// first so that integer order is byte order. Bytes past the end of the line
+// read as 0.
+static inline uint64_t loadKey(const LineTable* T, int i, size_t depth) {
+    LineView v = T->view[i];
+    const unsigned char* p = (const unsigned char*)T->text + v.offset + depth;
+    size_t n = (v.length > depth ? v.length - depth : 0);
+    uint64_t k = 0;
+    if (n >= KEY_BYTES) {
+        k = (uint64_t)p[0] << 56 | (uint64_t)p[1] << 48 | (uint64_t)p[2] << 40 |
+            (uint64_t)p[3] << 32 | (uint64_t)p[4] << 24 | (uint64_t)p[5] << 16 |
+            (uint64_t)p[6] << 8 | (uint64_t)p[7];
+    }
+    else {
+        for (size_t j = 0; j < n; j++) {
+            k |= (uint64_t)p[j] << (56 - 8 * j);
+        }
+    }
+    return k;
+}
+
+// keyBefore()
+// Returns true (1) iff a goes before b, given that their lines agree on the
+// first depth bytes.
+static inline int keyBefore(const LineTable* T, KeyObj a, KeyObj b, size_t depth) {
+    if (a.key != b.key) {
+        return a.key < b.key;
+    }
+    LineView x = T->view[a.index];
+    LineView y = T->view[b.index];
+    x.offset += depth;
+    x.length -= (x.length < depth ? x.length : depth);
+    y.offset += depth;
+    y.length -= (y.length < depth ? y.length : depth);
+    return compareViews(T->text, x, y) < 0;
+}
+
+// insertionSort()
+// Sorts the n keys of a whose lines agree on the first depth bytes.
+static void insertionSort(const LineTable* T, KeyObj* a, int n, size_t depth) {
+    for (int i = 1; i < n; i++) {
+        KeyObj x = a[i];
+        int j = i;
+        while (j > 0 && keyBefore(T, x, a[j - 1], depth)) {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = x;
+    }
+}
+
+// median()
+// Returns the median of x, y and z.
+static inline uint64_t median(uint64_t x, uint64_t y, uint64_t z) {
+    if (x < y) {
+        return (y < z ? y : (x < z ? z : x));
+    }
+    return (x < z ? x : (y < z ? z : y));
+}
+
+// sortEnded()
+// Puts first, shortest first, the lines among the n keys of a that end
+// within the first depth+KEY_BYTES bytes, which they agree on once padded
+// with 0. Those lines are prefixes of the rest, so they are then in place.
+// Loads the chunk at depth+KEY_BYTES into the keys of the rest and returns
+// how many lines ended.
+static int sortEnded(const LineTable* T, KeyObj* a, int n, size_t depth) {
+    int ended = 0;
+    for (int i = 0; i < n; i++) {
+        if (T->view[a[i].index].length <= depth + KEY_BYTES) {
+            KeyObj t = a[ended];
+            a[ended++] = a[i];
+            a[i] = t;
+        }
+    }
+    for (int i = 1; i < ended; i++) {
+        KeyObj x = a[i];
+        int j = i;
+        while (j > 0 && T->view[a[j - 1].index].length > T->view[x.index].length) {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = x;
+    }
+    for (int i = ended; i < n; i++) {
+        a[i].key = loadKey(T, a[i].index, depth + KEY_BYTES);
+    }
+    return ended;
+}
+
+// sortKeys()
+// Sorts the n keys of a, whose lines agree on the first depth bytes and
+// whose keys hold the chunk at depth. Splits three ways around a median
+// key, then recurses into the two smaller of the lesser part, the greater
+// part and the equal part, which goes on at the next chunk, and loops on
+// the largest. Every call thus has at most half the keys of its caller, so
+// however long a prefix the lines share the stack stays O(log n) deep.
+static void sortKeys(const LineTable* T, KeyObj* a, int n, size_t depth) {
+    while (n > INSERTION_LIMIT) {
+        uint64_t p = median(a[0].key, a[n / 2].key, a[n - 1].key);
+        int lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            if (a[i].key < p) {
+                KeyObj t = a[lt];
+                a[lt++] = a[i];
+                a[i++] = t;
+            }
+            else if (a[i].key > p) {
+                KeyObj t = a[--gt];
+                a[gt] = a[i];
+                a[i] = t;
+            }
+            else {
+                i++;
+            }
+        }
+        int eq = lt + sortEnded(T, a + lt, gt - lt, depth);
+        int less = lt, equal = gt - eq, greater = n - gt;
+        if (equal >= less && equal >= greater) {
+            sortKeys(T, a, less, depth);
+            sortKeys(T, a + gt, greater, depth);
+            a += eq;
+            n = equal;
+            depth += KEY_BYTES;
+        }
+        else if (less >= greater) {
+            sortKeys(T, a + eq, equal, depth + KEY_BYTES);
+            sortKeys(T, a + gt, greater, depth);
+            n = less;
+        }
+        else {
+            sortKeys(T, a, less, depth);
+            sortKeys(T, a + eq, equal, depth + KEY_BYTES);
+            a += gt;
+            n = greater;
+        }
+    }
+    insertionSort(T, a, n, depth);
+}
+
+// radixSort()
+// Sorts the n line indices in order by the lines they refer to in table,
+// into the order of compareViews(). This is a multikey quicksort over
+// 8-byte chunks of the lines: every index is kept next to a cached copy of
+// the chunk of its line at the current depth, so most comparisons are a
+// single integer compare, and a shared prefix is examined once per group
+// instead of once per comparison. Equal lines may change relative order,
+// which cannot be told apart in the output.
+// Pre: table != NULL, order != NULL, n >= 0
+void radixSort(const LineTable* table, int* order, int n) {
+    if (table == NULL || order == NULL) {
+        fprintf(stderr, "StringSort Error: calling radixSort() on NULL reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if (n < 0) {
+        fprintf(stderr, "StringSort Error: calling radixSort() with negative size\n");
+        exit(EXIT_FAILURE);
+    }
+    KeyObj* a = malloc((n > 0 ? n : 1) * sizeof(KeyObj));
+    for (int i = 0; i < n; i++) {
+        a[i].index = order[i];
+        a[i].key = loadKey(table, order[i], 0);
+    }
+    sortKeys(table, a, n, 0);
+    for (int i = 0; i < n; i++) {
+        order[i] = a[i].index;
+    }
+    free(a);
+}
@@ -0,0 +1,19 @@
+/*
+ * File:   StringSort.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ */
+
+#include "Lines.h"
+
+// Other operations -----------------------------------------------------------
+
+// radixSort()
+// Sorts the n line indices in order by the lines they refer to in table,
+// into the order of compareViews(). This is a multikey quicksort over
+// 8-byte chunks of the lines: every index is kept next to a cached copy of
+// the chunk of its line at the current depth, so most comparisons are a
+// single integer compare, and a shared prefix is examined once per group
+// instead of once per comparison. Equal lines may change relative order,
+// which cannot be told apart in the output.
+// Pre: table != NULL, order != NULL, n >= 0
+void radixSort(const LineTable* table, int* order, int n);
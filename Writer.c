@@ -0,0 +1,309 @@
+/*
+ * File:   Writer.c
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<errno.h>
+#include<unistd.h>
+#include<sys/uio.h>
+#include "Writer.h"
+
+// Bytes of copied and formatted output held before a flush.
+#define WRITER_BUFFER 65536
+
+// Pieces gathered into one writev(), within the IOV_MAX of Linux.
+#define WRITER_PIECES 1024
+
+// Views shorter than this are copied into the buffer, which costs less
+// than a piece of their own.
+#define WRITER_GATHER 512
+
+// private WriterObj type
+// iov lists the pieces to write, in order: runs of buffer and views of
+// the caller's text. The latest views, while each continues the one before,
+// are held as one run in view until something else is written.
+typedef struct WriterObj {
+    FILE* out;
+    int fd;                 // file descriptor of out, or -1 to use out
+    int error;              // errno of the first failed write, else 0
+    int pieces;
+    size_t used;            // bytes of buffer taken
+    char* buffer;
+    const char* view;       // run of views not yet made a piece, or NULL
+    size_t view_length;
+    struct iovec iov[WRITER_PIECES];
+} WriterObj;
+
+// Decimal digits of 0 to 99, two characters each.
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Private functions ----------------------------------------------------------
+
+// drain()
+// Writes every piece of W and empties it. After a failed write, recorded in
+// W->error, the rest of the output is dropped. The held run of views is
+// left alone.
+static void drain(Writer W) {
+    struct iovec* v = W->iov;
+    int k = W->pieces;
+    while (k > 0 && W->error == 0) {
+        if (W->fd < 0) {
+            errno = 0;
+            if (fwrite(v->iov_base, 1, v->iov_len, W->out) != v->iov_len) {
+                W->error = (errno != 0 ? errno : EIO);
+            }
+            v++;
+            k--;
+            continue;
+        }
+        ssize_t n = writev(W->fd, v, k);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            W->error = errno;
+            break;
+        }
+        // skip what was written, resuming a partly written piece
+        while (k > 0 && (size_t)n >= v->iov_len) {
+            n -= v->iov_len;
+            v++;
+            k--;
+        }
+        if (k > 0) {
+            v->iov_base = (char*)v->iov_base + n;
+            v->iov_len -= n;
+        }
+    }
+    W->pieces = 0;
+    W->used = 0;
+}
+
+// reserve()
+// Returns where n more bytes, n <= WRITER_BUFFER, may be put in the buffer
+// of W, draining W first if they would not fit or could not become a piece.
+static char* reserve(Writer W, size_t n) {
+    int extends = (W->pieces > 0 &&
+        (char*)W->iov[W->pieces - 1].iov_base + W->iov[W->pieces - 1].iov_len == W->buffer + W->used);
+    if (WRITER_BUFFER - W->used < n || (!extends && W->pieces == WRITER_PIECES)) {
+        drain(W);
+    }
+    return W->buffer + W->used;
+}
+
+// commit()
+// Adds the n bytes just put at the end of the buffer of W, after reserve(),
+// to the output.
+static void commit(Writer W, size_t n) {
+    char* p = W->buffer + W->used;
+    struct iovec* last = W->iov + W->pieces;
+    if (W->pieces > 0 && (char*)last[-1].iov_base + last[-1].iov_len == p) {
+        last[-1].iov_len += n;
+    }
+    else {
+        W->iov[W->pieces].iov_base = p;
+        W->iov[W->pieces].iov_len = n;
+        W->pieces++;
+    }
+    W->used += n;
+}
+
+// copyBytes()
+// Copies the n bytes at s into the buffer of W.
+static void copyBytes(Writer W, const char* s, size_t n) {
+    while (n > 0) {
+        size_t k = (n < WRITER_BUFFER ? n : WRITER_BUFFER);
+        memcpy(reserve(W, k), s, k);
+        commit(W, k);
+        s += k;
+        n -= k;
+    }
+}
+
+// settle()
+// Makes the held run of views of W a piece of its own, or copies it into
+// the buffer if it is short.
+static void settle(Writer W) {
+    if (W->view == NULL) {
+        return;
+    }
+    if (W->view_length < WRITER_GATHER) {
+        copyBytes(W, W->view, W->view_length);
+    }
+    else {
+        if (W->pieces == WRITER_PIECES) {
+            drain(W);
+        }
+        W->iov[W->pieces].iov_base = (char*)W->view;
+        W->iov[W->pieces].iov_len = W->view_length;
+        W->pieces++;
+    }
+    W->view = NULL;
+}
+
+// formatInt()
+// Writes x in decimal and a space at p. Returns the end of what it wrote.
+static char* formatInt(char* p, int x) {
+    char digits[WRITER_INT_CHARS];
+    char* d = digits + WRITER_INT_CHARS;
+    unsigned u = (x < 0 ? 0u - (unsigned)x : (unsigned)x);
+    *--d = ' ';
+    while (u >= 100) {
+        unsigned r = u % 100;
+        u /= 100;
+        d -= 2;
+        memcpy(d, digit_pairs + 2 * r, 2);
+    }
+    if (u >= 10) {
+        d -= 2;
+        memcpy(d, digit_pairs + 2 * u, 2);
+    }
+    else {
+        *--d = (char)('0' + u);
+    }
+    if (x < 0) {
+        *--d = '-';
+    }
+    size_t n = digits + WRITER_INT_CHARS - d;
+    memcpy(p, d, n);
+    return p + n;
+}
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newWriter()
+// Returns reference to a new Writer onto out, flushing out first.
+// Pre: out != NULL
+Writer newWriter(FILE* out) {
+    if (out == NULL) {
+        fprintf(stderr, "Writer Error: calling newWriter() on NULL file pointer\n");
+        exit(EXIT_FAILURE);
+    }
+    Writer W = malloc(sizeof(WriterObj));
+    W->out = out;
+    W->error = (fflush(out) != 0 ? errno : 0);
+    W->fd = fileno(out);
+    W->pieces = 0;
+    W->used = 0;
+    W->buffer = malloc(WRITER_BUFFER);
+    W->view = NULL;
+    W->view_length = 0;
+    return(W);
+}
+
+// freeWriter()
+// Flushes W, frees all memory associated with Writer *pW, and sets *pW to
+// NULL. Returns 0, or -1 with errno set if any write of W failed.
+// Pre: Writer != NULL
+int freeWriter(Writer* pW) {
+    if (pW == NULL || *pW == NULL) {
+        fprintf(stderr, "Writer Error: calling freeWriter() on NULL Writer reference\n");
+        exit(EXIT_FAILURE);
+    }
+    int result = flushWriter(*pW);
+    int error = errno;
+    free((*pW)->buffer);
+    free(*pW);
+    *pW = NULL;
+    errno = error;
+    return result;
+}
+
+// Manipulation procedures ----------------------------------------------------
+
+// writeInts()
+// Writes the n ints of data in decimal, each followed by a space.
+// Pre: Writer != NULL, data != NULL if n > 0
+void writeInts(Writer W, const int* data, int n) {
+    if (W == NULL) {
+        fprintf(stderr, "Writer Error: calling writeInts() on NULL Writer reference\n");
+        exit(EXIT_FAILURE);
+    }
+    settle(W);
+    while (n > 0) {
+        int k = (n < WRITER_BUFFER / WRITER_INT_CHARS ? n : WRITER_BUFFER / WRITER_INT_CHARS);
+        char* start = reserve(W, (size_t)k * WRITER_INT_CHARS);
+        char* p = start;
+        for (int i = 0; i < k; i++) {
+            p = formatInt(p, data[i]);
+        }
+        commit(W, p - start);
+        data += k;
+        n -= k;
+    }
+}
+
+// writeBytes()
+// Writes a copy of the n bytes at s.
+// Pre: Writer != NULL, s != NULL if n > 0
+void writeBytes(Writer W, const char* s, size_t n) {
+    if (W == NULL) {
+        fprintf(stderr, "Writer Error: calling writeBytes() on NULL Writer reference\n");
+        exit(EXIT_FAILURE);
+    }
+    settle(W);
+    copyBytes(W, s, n);
+}
+
+// writeView()
+// Writes the n bytes at s, which must not change until W is flushed or
+// freed, holding them back in case the next view continues them.
+// Pre: Writer != NULL, s != NULL if n > 0
+void writeView(Writer W, const char* s, size_t n) {
+    if (W == NULL) {
+        fprintf(stderr, "Writer Error: calling writeView() on NULL Writer reference\n");
+        exit(EXIT_FAILURE);
+    }
+    if (n == 0) {
+        return;
+    }
+    if (W->view != NULL && W->view + W->view_length == s) {
+        W->view_length += n;
+        return;
+    }
+    settle(W);
+    W->view = s;
+    W->view_length = n;
+}
+
+// flushWriter()
+// Writes out everything W holds. Returns 0, or -1 with errno set if this
+// or any earlier write of W failed.
+// Pre: Writer != NULL
+int flushWriter(Writer W) {
+    if (W == NULL) {
+        fprintf(stderr, "Writer Error: calling flushWriter() on NULL Writer reference\n");
+        exit(EXIT_FAILURE);
+    }
+    settle(W);
+    drain(W);
+    if (W->fd < 0 && W->error == 0 && fflush(W->out) != 0) {
+        W->error = errno;
+    }
+    if (W->error != 0) {
+        errno = W->error;
+        return -1;
+    }
+    return 0;
+}
+
+// Other operations -----------------------------------------------------------
+
+// formatInts()
+// Formats the n ints of data at s as writeInts() writes them, and returns
+// the number of bytes formatted.
+// Pre: s has room for n * WRITER_INT_CHARS bytes, data != NULL if n > 0
+size_t formatInts(char* s, const int* data, int n) {
+    char* p = s;
+    for (int i = 0; i < n; i++) {
+        p = formatInt(p, data[i]);
+    }
+    return p - s;
+}
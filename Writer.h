@@ -0,0 +1,75 @@
+/*
+ * File:   Writer.h
+ * Author: Mason Woodford (mwoodfor@ucsc.edu)
+ */
+
+#ifndef WRITER_H_INCLUDE_
+#define WRITER_H_INCLUDE_
+
+#include<stdio.h>
+#include<stddef.h>
+
+// Exported type --------------------------------------------------------------
+
+// A Writer gathers output for a stdio stream and hands it to the kernel in
+// few, large writev() calls instead of going through stdio: ints are
+// formatted into a buffer of its own, and long views of text that stays
+// put, such as runs of lines of a Lines object, are written straight from
+// where they lie without being copied.
+typedef struct WriterObj* Writer;
+
+// Longest an int and the space after it can be: "-2147483648 ".
+#define WRITER_INT_CHARS 12
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newWriter()
+// Returns reference to a new Writer onto out, flushing out first. Output
+// goes to the file descriptor of out with writev(), or through out itself
+// if it has none.
+// Pre: out != NULL
+Writer newWriter(FILE* out);
+
+// freeWriter()
+// Flushes W, frees all memory associated with Writer *pW, and sets *pW to
+// NULL. Returns 0, or -1 with errno set if any write of W failed.
+// Pre: Writer != NULL
+int freeWriter(Writer* pW);
+
+// Manipulation procedures ----------------------------------------------------
+
+// writeInts()
+// Writes the n ints of data in decimal, each followed by a space, as
+// printList() prints them.
+// Pre: Writer != NULL, data != NULL if n > 0
+void writeInts(Writer W, const int* data, int n);
+
+// writeBytes()
+// Writes a copy of the n bytes at s.
+// Pre: Writer != NULL, s != NULL if n > 0
+void writeBytes(Writer W, const char* s, size_t n);
+
+// writeView()
+// Writes the n bytes at s, which must not change until W is flushed or
+// freed. Views that each start where the one before ended are merged, and
+// a run of them that is long enough is written in place, without being
+// copied; shorter ones are copied, as that costs less.
+// Pre: Writer != NULL, s != NULL if n > 0
+void writeView(Writer W, const char* s, size_t n);
+
+// flushWriter()
+// Writes out everything W holds. Returns 0, or -1 with errno set if this
+// or any earlier write of W failed.
+// Pre: Writer != NULL
+int flushWriter(Writer W);
+
+// Other operations -----------------------------------------------------------
+
+// formatInts()
+// Formats the n ints of data at s as writeInts() writes them, and returns
+// the number of bytes formatted. For short output printed now and then,
+// where a Writer of its own would cost more than it saves.
+// Pre: s has room for n * WRITER_INT_CHARS bytes, data != NULL if n > 0
+size_t formatInts(char* s, const int* data, int n);
+
+#endif